@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cerrno>     // errno, EINTR
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // read, write
+
+// Reads whitespace separated tokens from a file descriptor. If it refers to
+// a regular file, the whole file is mapped into memory and parsed in place,
+// otherwise (pipes, terminals) it is read through a large buffer.
+struct input_reader {
+	explicit input_reader(int fd = 0)
+	: fd_{fd} {
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+			void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				madvise(p, st.st_size, MADV_SEQUENTIAL);
+				mapped_size_ = st.st_size;
+				cur_ = static_cast<const char *>(p);
+				end_ = cur_ + st.st_size;
+				return;
+			}
+		}
+
+		buffer_ = new char[buffer_size];
+		cur_ = end_ = buffer_;
+	}
+
+	input_reader(const input_reader &other) = delete;
+	input_reader(input_reader &&other) = delete;
+	input_reader &operator=(const input_reader &other) = delete;
+	input_reader &operator=(input_reader &&other) = delete;
+
+	~input_reader() {
+		if (mapped_size_)
+			munmap(const_cast<char *>(end_ - mapped_size_), mapped_size_);
+		delete[] buffer_;
+	}
+
+	// Reads an optionally signed decimal integer, returns false if the
+	// input ended before one was found, or the next token doesn't start
+	// with one, which is left unread (but for its sign) like scanf does.
+	bool read_int(int &out) {
+		if (!skip_space_()) return false;
+
+		bool negative = false;
+		if (*cur_ == '-' || *cur_ == '+') {
+			negative = *cur_ == '-';
+			cur_++;
+			if (!refill_if_empty_()) return false;
+		}
+
+		unsigned int value = 0;
+		bool any_digits = false;
+		while (true) {
+			if (cur_ == end_ && !refill_()) break;
+
+			unsigned int digit = static_cast<unsigned char>(*cur_) - '0';
+			if (digit > 9) break;
+
+			value = value * 10 + digit;
+			any_digits = true;
+			cur_++;
+		}
+
+		if (!any_digits) return false;
+		out = negative ? -static_cast<int>(value) : static_cast<int>(value);
+		return true;
+	}
+
+	// Reads the next non-whitespace character.
+	bool read_char(char &out) {
+		if (!skip_space_()) return false;
+
+		out = *cur_++;
+		return true;
+	}
+
+private:
+	static constexpr int buffer_size = 1 << 16;
+
+	static bool is_space_(char c) {
+		return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	bool skip_space_() {
+		while (true) {
+			if (!refill_if_empty_()) return false;
+			if (!is_space_(*cur_)) return true;
+			cur_++;
+		}
+	}
+
+	bool refill_if_empty_() {
+		return cur_ != end_ || refill_();
+	}
+
+	bool refill_() {
+		// A mapped file is entirely in memory already.
+		if (!buffer_) return false;
+
+		ssize_t n;
+		do {
+			n = read(fd_, buffer_, buffer_size);
+		} while (n < 0 && errno == EINTR);
+
+		if (n <= 0) return false;
+
+		cur_ = buffer_;
+		end_ = buffer_ + n;
+		return true;
+	}
+
+	const int fd_;
+	const char *cur_ = nullptr, *end_ = nullptr;
+	char *buffer_ = nullptr;
+	long long mapped_size_ = 0;
+};
+
+// Collects output in a large buffer, and writes it out only when the buffer
+// fills up, on flush(), or on destruction.
+struct output_writer {
+	explicit output_writer(int fd = 1)
+	: fd_{fd}, buffer_{new char[buffer_size]} { }
+
+	output_writer(const output_writer &other) = delete;
+	output_writer(output_writer &&other) = delete;
+	output_writer &operator=(const output_writer &other) = delete;
+	output_writer &operator=(output_writer &&other) = delete;
+
+	~output_writer() {
+		flush();
+		delete[] buffer_;
+	}
+
+	void write_char(char c) {
+		if (size_ == buffer_size) flush();
+		buffer_[size_++] = c;
+	}
+
+	void write_str(const char *s) {
+		while (*s) write_char(*s++);
+	}
+
+	void write_bytes(const void *data, long long size) {
+		auto p = static_cast<const char *>(data);
+		while (size--) write_char(*p++);
+	}
+
+	void write_int(int value) {
+		// Enough for any 32-bit int with its sign.
+		if (size_ + 11 > buffer_size) flush();
+
+		unsigned int u = value;
+		if (value < 0) {
+			buffer_[size_++] = '-';
+			u = -u;
+		}
+
+		// Two digits at a time, from the end.
+		char digits[10];
+		int n = 10;
+		while (u >= 100) {
+			const char *pair = digit_pairs + u % 100 * 2;
+			u /= 100;
+			digits[--n] = pair[1];
+			digits[--n] = pair[0];
+		}
+
+		if (u >= 10) {
+			digits[--n] = digit_pairs[u * 2 + 1];
+			digits[--n] = digit_pairs[u * 2];
+		} else {
+			digits[--n] = '0' + u;
+		}
+
+		__builtin_memcpy(buffer_ + size_, digits + n, 10 - n);
+		size_ += 10 - n;
+	}
+
+	// Returns false if anything written so far failed to be written out.
+	bool flush() {
+		const char *p = buffer_;
+		while (size_ > 0) {
+			ssize_t n = write(fd_, p, size_);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) {
+				failed_ = true;
+				break;
+			}
+
+			p += n;
+			size_ -= n;
+		}
+
+		size_ = 0;
+		return !failed_;
+	}
+
+private:
+	static constexpr int buffer_size = 1 << 16;
+	static constexpr char digit_pairs[] =
+		"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+		"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+	const int fd_;
+	char *const buffer_;
+	int size_ = 0;
+	bool failed_ = false;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <ctime>
+#include <sys/resource.h> // getrusage
+
+// Monotonic wall clock time in nanoseconds.
+inline long long now_ns() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Sorts the samples in place and returns the given percentile, the
+// smallest sample that's at least as large as that share of them.
+inline long long percentile_ns(long long *samples, int n, int percent) {
+	for (int i = 1; i < n; i++) {
+		long long s = samples[i];
+		int j = i;
+		for (; j > 0 && samples[j - 1] > s; j--)
+			samples[j] = samples[j - 1];
+		samples[j] = s;
+	}
+
+	int i = static_cast<int>(static_cast<long long>(n) * percent / 100);
+	return samples[i < n ? i : n - 1];
+}
+
+// Sorts the samples in place and returns the median.
+inline long long median_ns(long long *samples, int n) {
+	return percentile_ns(samples, n, 50);
+}
+
+// Peak resident set size of the process so far, in bytes.
+inline long long peak_rss_bytes() {
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss * 1024LL;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <climits>
+
+#include "containers.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "stats.hpp"
+#include "types.hpp"
+
+inline int manhattan(vertex a, vertex b) {
+	int dx = a.x - b.x, dy = a.y - b.y;
+	return (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+}
+
+// Every grid edge costs at least 1, so the Manhattan distance to the target
+// is a lower bound on the remaining time, as long as no lifts are taken.
+struct manhattan_heuristic {
+	manhattan_heuristic(const map &, vertex target)
+	: target{target} { }
+
+	int operator()(vertex v) const {
+		return manhattan(v, target);
+	}
+
+	vertex target;
+};
+
+// A path that takes any lifts has to finish from the destination of the
+// last one. Walking costs at least 1 per step, and a lift at least its
+// travel time, so the time from boarding a lift to the target is at least
+// its bound: the travel time plus the shortest such walk, with lifts on
+// the way, from its destination. Bounds are found like distances in
+// dijkstra(), over the lifts rather than the grid, taking O(lifts) per
+// lift.
+//
+// The heuristic is the smallest of the Manhattan distance and the
+// Manhattan distance to the origin of a lift plus its bound, for the
+// max_shortcuts lifts with the lowest bounds, and the lowest bound of the
+// others for all the rest. Lifts which don't beat walking from their
+// origin are left out, they can't lower it. Each term changes by at most
+// 1 per step, and at the origin of any lift the heuristic is at most its
+// bound, so it stays admissible and consistent.
+struct lift_heuristic {
+	lift_heuristic(const map &m, vertex target)
+	: target{target} {
+		auto all = m.all_lifts();
+		lift_bound *lifts = new lift_bound[all.size() > 0 ? all.size() : 1];
+		int n = 0;
+
+		for (auto l : all) {
+			if (l.travel_time < manhattan(l.from, target))
+				lifts[n++] = {l.from, l.to, l.travel_time, l.travel_time + manhattan(l.to, target)};
+		}
+
+		// The first n lifts are the ones whose bounds aren't final yet,
+		// the lowest of them is final once every lower one is relaxed.
+		// Lifts are only ever useful in the order they come out, so the
+		// search stops once max_shortcuts + 1 of them have.
+		int next = lowest_(lifts, n);
+
+		while (n && other_lifts == INT_MAX) {
+			lift_bound l = lifts[next];
+			lifts[next] = lifts[--n];
+
+			// A lift that doesn't beat walking from its origin can't be
+			// the shortcut for any other.
+			bool useful = l.bound < manhattan(l.from, target);
+			if (useful && n_shortcuts < max_shortcuts) shortcuts[n_shortcuts++] = {l.from, l.bound};
+			else if (useful) other_lifts = l.bound;
+
+			if (useful) {
+				for (int i = 0; i < n; i++) {
+					int via = lifts[i].travel_time + manhattan(lifts[i].to, l.from) + l.bound;
+					if (via < lifts[i].bound) lifts[i].bound = via;
+				}
+			}
+
+			next = lowest_(lifts, n);
+		}
+
+		delete[] lifts;
+	}
+
+	int operator()(vertex v) const {
+		int h = manhattan(v, target);
+		if (other_lifts < h) h = other_lifts;
+
+		// By increasing bound, so none after one that's already too high
+		// can help.
+		for (int i = 0; i < n_shortcuts && shortcuts[i].bound < h; i++) {
+			int via = manhattan(v, shortcuts[i].from) + shortcuts[i].bound;
+			if (via < h) h = via;
+		}
+
+		return h;
+	}
+
+	// Few enough to check for every vertex, and the ones past the first
+	// few rarely lower anything.
+	static constexpr int max_shortcuts = 8;
+
+	struct shortcut {
+		vertex from;
+		int bound;
+	};
+
+	vertex target;
+	shortcut shortcuts[max_shortcuts];
+	int n_shortcuts = 0;
+	// The lowest bound of the useful lifts past the shortcuts.
+	int other_lifts = INT_MAX;
+
+private:
+	struct lift_bound {
+		vertex from, to;
+		int travel_time;
+		int bound;
+	};
+
+	static int lowest_(const lift_bound *lifts, int n) {
+		int lowest = 0;
+		for (int i = 1; i < n; i++) {
+			if (lifts[i].bound < lifts[lowest].bound) lowest = i;
+		}
+
+		return lowest;
+	}
+};
+
+// A* search, i.e. dijkstra() with the queue ordered by the distance from
+// the source plus the heuristic estimate of the distance to the target.
+// Heuristic must be consistent, in which case every vertex is settled at
+// most once, just like in dijkstra(). Like dijkstra(), the state is
+// cleared before the search, so it can be reused between searches.
+template <typename Heuristic, typename Queue>
+search_result astar(const map &m, vertex source, vertex target, const Heuristic &h,
+		search_state<Queue> &state) {
+	auto &dist = state.dist;
+	auto &Q = state.Q;
+	int settled = 0;
+
+	Q.clear();
+	dist.reset();
+	stats::queue_cleared();
+
+	dist.set(source, 0);
+	Q.insert(h(source), source);
+	stats::pushed();
+
+	while (!Q.empty()) {
+		auto [priority, u] = Q.extract_min();
+		int dist_u = dist[u];
+		bool stale = priority > dist_u + h(u);
+		stats::popped(stale);
+		if (stale) continue;
+
+		settled++;
+		if (u == target) break;
+
+		m.compute_neighbors(dist_u, u, state.neighbors);
+		stats::relaxed(state.neighbors.size());
+
+		for (auto [v, edge] : state.neighbors) {
+			auto alt = dist_u + edge;
+
+			if (alt < dist[v]) {
+				dist.set(v, alt);
+				bool added = Q.insert(alt + h(v), v);
+				stats::inserted(added);
+			}
+		}
+	}
+
+	return {dist[target], settled};
+}
+
+template <typename Heuristic, typename Queue = dary_heap<4>>
+search_result astar(const map &m, vertex source, vertex target) {
+	search_state<Queue> state{m};
+	return astar(m, source, target, Heuristic{m, target}, state);
+}
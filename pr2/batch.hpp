@@ -0,0 +1,37 @@
+#pragma once
+
+#include "dijkstra.hpp"
+#include "map.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+struct route_query {
+	vertex source;
+	vertex target;
+};
+
+// Answers all queries with dijkstra(), spread over the threads of the
+// pool. The graph is only read, and every thread gets its own search_state,
+// which is kept for all the queries that thread picks up. Threads take
+// the next unanswered query as they go, so uneven query costs even out.
+template <typename Queue, typename Graph, typename... Args>
+void batch_route(const Graph &g, const route_query *queries, search_result *results, int n,
+		thread_pool &pool, Args... queue_args) {
+	int next = 0;
+
+	auto job = [&] (int) {
+		search_state<Queue, typename Graph::layout> state{g, queue_args...};
+
+		while (true) {
+			int i = __atomic_fetch_add(&next, 1, __ATOMIC_RELAXED);
+			if (i >= n) break;
+
+			results[i] = dijkstra(g, queries[i].source, queries[i].target, state);
+		}
+
+		stats::flush_thread();
+	};
+
+	pool.run(job);
+}
@@ -0,0 +1,755 @@
+#include <climits>  // INT_MAX
+#include <cstdio>   // printf
+#include <cstdlib>  // atoi
+#include <cstring>  // strcmp
+#include <unistd.h> // sysconf
+
+#include "../common/fast_io.hpp"
+#include "../common/timing.hpp"
+#include "astar.hpp"
+#include "batch.hpp"
+#include "bidirectional.hpp"
+#include "compact_graph.hpp"
+#include "cost_kernel.hpp"
+#include "delta_stepping.hpp"
+#include "dijkstra.hpp"
+#include "generator.hpp"
+#include "heap.hpp"
+#include "incremental.hpp"
+#include "landmarks.hpp"
+#include "layout.hpp"
+#include "map.hpp"
+#include "perf_counters.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+// Reads a map in the same format as pr2 from stdin, and runs one of the
+// benchmark suites on it:
+//
+//	queues:  runs the query from the header with each priority queue
+//	         backend and search algorithm, reporting the median time and
+//	         the number of settled vertices.
+//	threads: answers a batch of random queries with batch_route() on
+//	         1, 2, 4, ... threads, reporting the throughput.
+//	compact: compares searching the map directly against searching the
+//	         precomputed compact_graph, in memory use and time.
+//	kernel:  times compute_grid_costs with each instruction set the CPU
+//	         supports, checking them against the scalar version.
+//	layout:  runs the query on maps (and distance tables) with each of
+//	         the array2d layouts, reporting time and cache misses.
+//	alt:     answers a batch of random queries with ALT, with different
+//	         numbers of landmarks, reporting the preprocessing time and
+//	         the speedup over Dijkstra's algorithm.
+//	profile: answers random queries for every departure time in a window,
+//	         with profile_router and with a search per departure,
+//	         reporting the speedup and the searches the profile needed.
+//	incremental: edits the map between queries, changing heights and
+//	         closing and reopening lifts, and compares repairing the last
+//	         answer with incremental_router against searching again.
+//
+// Usage: pr2-bench [queues | threads | compact | kernel | layout | alt | profile | incremental] [runs] < tests/18.in
+//
+// The matrix suite doesn't read a map, instead it generates a set of maps
+// of different shapes (see generator.hpp), and times random queries on
+// each with every queue, layout and algorithm, reporting the median and
+// 99th percentile times. Every answer is checked against dijkstra() with
+// the pairing heap, the original implementation.
+//
+// Usage: pr2-bench matrix [runs]
+//
+// The delta suite also generates its maps, and runs the corner to corner
+// query with delta-stepping, for each delta on 1, 2, 4, ... threads up to
+// the number of CPUs, reporting the median time and the speedup over
+// dijkstra() with the radix heap.
+//
+// Usage: pr2-bench delta [runs]
+
+namespace {
+
+int expected = -1;
+bool mismatch = false;
+
+template <typename Graph>
+void bench_solver(const char *name, search_result (*solve)(const Graph &, vertex, vertex),
+		const Graph &g, vertex start, vertex end, int runs) {
+	long long *samples = new long long[runs];
+	search_result result{};
+
+	for (int i = 0; i < runs; i++) {
+		auto t0 = now_ns();
+		result = solve(g, start, end);
+		samples[i] = now_ns() - t0;
+	}
+
+	auto median = median_ns(samples, runs);
+	printf("%-22s %10.3f ms %12.1f queries/s %10d settled  (answer %d)\n",
+			name, median / 1e6, 1e9 / median, result.settled, result.time);
+
+	if (expected < 0) expected = result.time;
+	else if (expected != result.time) mismatch = true;
+
+	delete[] samples;
+}
+
+void bench_queues(map &m, vertex start, vertex end, int runs) {
+	bench_solver("pairing_heap", dijkstra<pairing_heap>, m, start, end, runs);
+	bench_solver("indexed_pairing_heap", dijkstra<indexed_pairing_heap>, m, start, end, runs);
+	bench_solver("dary_heap<2>", dijkstra<dary_heap<2>>, m, start, end, runs);
+	bench_solver("dary_heap<4>", dijkstra<dary_heap<4>>, m, start, end, runs);
+	bench_solver("dary_heap<8>", dijkstra<dary_heap<8>>, m, start, end, runs);
+	bench_solver("radix_heap", dijkstra<radix_heap>, m, start, end, runs);
+	bench_solver("dial", dial, m, start, end, runs);
+	// The plain Manhattan heuristic is only admissible without lifts.
+	if (!m.n_lifts)
+		bench_solver("astar (manhattan)", astar<manhattan_heuristic>, m, start, end, runs);
+	bench_solver("astar (lift-aware)", astar<lift_heuristic>, m, start, end, runs);
+	bench_solver("bidirectional", bidirectional, m, start, end, runs);
+}
+
+// Small LCG so that the random queries are the same on every run.
+struct lcg {
+	unsigned long long state;
+
+	int next(int bound) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<int>((state >> 33) % bound);
+	}
+};
+
+void bench_threads(map &m, int runs) {
+	constexpr int n_queries = 64;
+	route_query queries[n_queries];
+	search_result results[n_queries];
+	int reference[n_queries];
+
+	lcg rng{42};
+	for (auto &q : queries) {
+		q.source = {rng.next(m.width), rng.next(m.height)};
+		q.target = {rng.next(m.width), rng.next(m.height)};
+	}
+
+	int n_cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+	if (n_cpus < 1) n_cpus = 1;
+
+	long long *samples = new long long[runs];
+	double base_rate = 0;
+
+	for (int n_threads = 1; ; n_threads = n_threads * 2 < n_cpus ? n_threads * 2 : n_cpus) {
+		thread_pool pool{n_threads};
+
+		for (int i = 0; i < runs; i++) {
+			auto t0 = now_ns();
+			batch_route<radix_heap>(m, queries, results, n_queries, pool);
+			samples[i] = now_ns() - t0;
+		}
+
+		for (int i = 0; i < n_queries; i++) {
+			if (n_threads == 1) reference[i] = results[i].time;
+			else if (reference[i] != results[i].time) mismatch = true;
+		}
+
+		double rate = n_queries * 1e9 / median_ns(samples, runs);
+		if (n_threads == 1) base_rate = rate;
+
+		printf("%3d threads %12.1f queries/s %8.2fx\n",
+				n_threads, rate, rate / base_rate);
+
+		if (n_threads == n_cpus) break;
+	}
+
+	delete[] samples;
+}
+
+void bench_compact(map &m, vertex start, vertex end, int runs) {
+	if (!compact_graph::fits(m)) {
+		printf("grid edge costs don't fit into 16 bits, compact_graph is unusable\n");
+		return;
+	}
+
+	auto t0 = now_ns();
+	compact_graph g{m};
+	auto build_ns = now_ns() - t0;
+
+	printf("map:           %10.2f MiB\n", m.memory_bytes() / 1048576.0);
+	printf("compact_graph: %10.2f MiB, built in %.3f ms\n",
+			g.memory_bytes() / 1048576.0, build_ns / 1e6);
+
+	bench_solver("radix_heap (map)", dijkstra<radix_heap>, m, start, end, runs);
+	bench_solver("radix_heap (compact)", dijkstra<radix_heap>, g, start, end, runs);
+	bench_solver("dial (map)", dial, m, start, end, runs);
+	bench_solver("dial (compact)", dial, g, start, end, runs);
+}
+
+void bench_kernel(map &m, int runs) {
+	int cells = m.width * m.height;
+	grid_costs *reference = new grid_costs[cells];
+	grid_costs *out = new grid_costs[cells];
+	long long *samples = new long long[runs];
+
+	struct {
+		const char *name;
+		cost_kernel::isa isa;
+	} kernels[] = {
+		{"scalar", cost_kernel::isa::scalar},
+		{"sse4.1", cost_kernel::isa::sse41},
+		{"avx2", cost_kernel::isa::avx2},
+	};
+
+	compute_grid_costs(m.heights.data, m.width, m.height, reference, cost_kernel::isa::scalar);
+
+	for (auto [name, isa] : kernels) {
+		if (isa > cost_kernel::best_isa()) {
+			printf("%-8s unsupported\n", name);
+			continue;
+		}
+
+		for (int i = 0; i < runs; i++) {
+			auto t0 = now_ns();
+			compute_grid_costs(m.heights.data, m.width, m.height, out, isa);
+			samples[i] = now_ns() - t0;
+		}
+
+		for (int i = 0; i < cells; i++) {
+			auto a = reference[i], b = out[i];
+			if (a.left != b.left || a.right != b.right || a.up != b.up || a.down != b.down)
+				mismatch = true;
+		}
+
+		auto median = median_ns(samples, runs);
+		printf("%-8s %10.3f ms %10.1f Mcells/s\n", name, median / 1e6, cells * 1e3 / median);
+	}
+
+	delete[] samples;
+	delete[] out;
+	delete[] reference;
+}
+
+// Runs every query through route, returning the median time per query,
+// and filling in the results of the last run.
+template <typename Route>
+double time_queries(const route_query *queries, search_result *results, int n_queries,
+		int runs, Route route) {
+	long long *samples = new long long[runs];
+
+	for (int i = 0; i < runs; i++) {
+		auto t0 = now_ns();
+		for (int q = 0; q < n_queries; q++)
+			results[q] = route(queries[q].source, queries[q].target);
+		samples[i] = now_ns() - t0;
+	}
+
+	double per_query = static_cast<double>(median_ns(samples, runs)) / n_queries;
+	delete[] samples;
+	return per_query;
+}
+
+void bench_alt(map &m, int runs) {
+	constexpr int n_queries = 32;
+	route_query queries[n_queries];
+	search_result results[n_queries];
+	int reference[n_queries];
+
+	lcg rng{42};
+	for (auto &q : queries) {
+		q.source = {rng.next(m.width), rng.next(m.height)};
+		q.target = {rng.next(m.width), rng.next(m.height)};
+	}
+
+	auto average_settled = [&] {
+		long long sum = 0;
+		for (auto r : results) sum += r.settled;
+		return static_cast<int>(sum / n_queries);
+	};
+
+	router<radix_heap> r{m};
+	double base = time_queries(queries, results, n_queries, runs, [&] (vertex s, vertex t) {
+		return r.route(s, t);
+	});
+	for (int i = 0; i < n_queries; i++) reference[i] = results[i].time;
+
+	printf("%-16s %32s %10.3f ms/query %10d settled/query\n",
+			"dijkstra", "", base / 1e6, average_settled());
+
+	for (int count = 1; count <= 16; count *= 2) {
+		auto t0 = now_ns();
+		landmarks l{m, count};
+		auto prep_ns = now_ns() - t0;
+
+		alt_router<> ar{m, l};
+		double per_query = time_queries(queries, results, n_queries, runs, [&] (vertex s, vertex t) {
+			return ar.route(s, t);
+		});
+
+		for (int i = 0; i < n_queries; i++)
+			if (results[i].time != reference[i]) mismatch = true;
+
+		printf("alt, %2d landmarks  prep %10.1f ms %8.2f MiB %10.3f ms/query %10d settled/query %8.2fx\n",
+				count, prep_ns / 1e6, l.memory_bytes() / 1048576.0, per_query / 1e6,
+				average_settled(), base / per_query);
+	}
+}
+
+void bench_profile(map &m, int runs) {
+	constexpr int n_queries = 8;
+	route_query queries[n_queries];
+
+	lcg rng{42};
+	for (auto &q : queries) {
+		q.source = {rng.next(m.width), rng.next(m.height)};
+		q.target = {rng.next(m.width), rng.next(m.height)};
+	}
+
+	int period = schedule_period(m, INT_MAX);
+	if (period < INT_MAX) printf("lift schedules repeat every %d\n", period);
+
+	search_state<radix_heap> state{m};
+	profile_router<> pr{m};
+	long long *samples = new long long[runs];
+
+	int windows[] = {60, 600};
+	for (int window : windows) {
+		int *reference = new int[n_queries * window];
+		int *arrivals = new int[window];
+
+		for (int r = 0; r < runs; r++) {
+			auto t0 = now_ns();
+			for (int q = 0; q < n_queries; q++) {
+				for (int i = 0; i < window; i++) {
+					auto [s, t] = queries[q];
+					reference[q * window + i] = i + dijkstra(m, s, t, state, i).time;
+				}
+			}
+			samples[r] = now_ns() - t0;
+		}
+		double base = static_cast<double>(median_ns(samples, runs)) / n_queries;
+
+		long long searches = 0;
+		for (int r = 0; r < runs; r++) {
+			searches = 0;
+			auto t0 = now_ns();
+			for (int q = 0; q < n_queries; q++) {
+				auto [s, t] = queries[q];
+				searches += pr.route(s, t, 0, window, arrivals).searches;
+
+				for (int i = 0; i < window; i++)
+					if (arrivals[i] != reference[q * window + i]) mismatch = true;
+			}
+			samples[r] = now_ns() - t0;
+		}
+		double profile = static_cast<double>(median_ns(samples, runs)) / n_queries;
+
+		printf("%4d departures  one search each %10.3f ms/query  profile %10.3f ms/query"
+				" %8.1f searches/query %8.2fx\n", window, base / 1e6, profile / 1e6,
+				static_cast<double>(searches) / n_queries, base / profile);
+
+		delete[] reference;
+		delete[] arrivals;
+	}
+
+	delete[] samples;
+}
+
+void bench_incremental(map &m, vertex start, vertex end, int runs) {
+	int n_edits = 10 * runs;
+	lcg rng{42};
+
+	incremental_router ir{m};
+	search_state<radix_heap> state{m};
+
+	auto t0 = now_ns();
+	auto first = ir.route(start, end);
+	auto first_ns = now_ns() - t0;
+	printf("first search %10.3f ms %10d settled\n", first_ns / 1e6, first.settled);
+
+	long long *repair = new long long[n_edits];
+	long long *full = new long long[n_edits];
+	long long *settled = new long long[n_edits];
+
+	// Times an edit and the repair after it, then the search from scratch.
+	auto measure = [&] (const char *name, auto edit) {
+		for (int i = 0; i < n_edits; i++) {
+			auto t0 = now_ns();
+			edit(i);
+			auto result = ir.route(start, end);
+			repair[i] = now_ns() - t0;
+			settled[i] = result.settled;
+
+			t0 = now_ns();
+			auto reference = dijkstra(m, start, end, state);
+			full[i] = now_ns() - t0;
+
+			if (result.time != reference.time) mismatch = true;
+		}
+
+		long long settled_sum = 0;
+		for (int i = 0; i < n_edits; i++) settled_sum += settled[i];
+
+		auto full_median = median_ns(full, n_edits);
+		auto repair_median = percentile_ns(repair, n_edits, 50);
+		auto repair_p99 = percentile_ns(repair, n_edits, 99);
+		printf("%-16s repair median %10.3f ms  p99 %10.3f ms %10lld settled"
+				"  search %10.3f ms %8.1fx\n", name, repair_median / 1e6, repair_p99 / 1e6,
+				settled_sum / n_edits, full_median / 1e6,
+				static_cast<double>(full_median) / (repair_median > 0 ? repair_median : 1));
+	};
+
+	measure("raise a cell", [&] (int) {
+		vertex v{rng.next(m.width), rng.next(m.height)};
+		ir.set_height(v, m.heights[v] + 1 + rng.next(20));
+	});
+
+	measure("lower a cell", [&] (int) {
+		vertex v{rng.next(m.width), rng.next(m.height)};
+		ir.set_height(v, m.heights[v] - 1 - rng.next(20));
+	});
+
+	// Closing and then reopening the same lifts keeps n_lifts at most what
+	// the search state was made for.
+	if (m.all_lifts().size()) {
+		lift *closed = new lift[n_edits];
+
+		measure("close a lift", [&] (int i) {
+			auto current = m.all_lifts();
+			closed[i] = current.first[rng.next(current.size())];
+			ir.remove_lift(closed[i]);
+		});
+
+		measure("reopen a lift", [&] (int i) {
+			ir.insert_lift(closed[i]);
+		});
+
+		delete[] closed;
+	}
+
+	delete[] repair;
+	delete[] full;
+	delete[] settled;
+}
+
+// The same map, with a different layout.
+template <typename Layout>
+basic_map<Layout> *copy_map(const map &m) {
+	auto copy = new basic_map<Layout>{m.width, m.height, m.n_lifts};
+	copy->load_heights(m.heights.data, 0);
+
+	for (auto l : m.all_lifts()) copy->add_lift(l);
+	copy->index_lifts();
+	return copy;
+}
+
+template <typename Layout>
+void bench_layout(const char *name, const map &m, vertex start, vertex end, int runs) {
+	auto copy = copy_map<Layout>(m);
+	auto &lm = *copy;
+
+	perf_counters counters;
+	long long *samples = new long long[runs];
+	long long misses[perf_counters::n_counters] = {};
+	search_result result{};
+
+	for (int i = 0; i < runs; i++) {
+		counters.start();
+		auto t0 = now_ns();
+		result = dijkstra<radix_heap>(lm, start, end);
+		samples[i] = now_ns() - t0;
+		counters.stop();
+
+		// Keep the counts from the last run, they barely vary.
+		for (int c = 0; c < perf_counters::n_counters; c++)
+			misses[c] = counters.read_counter(static_cast<perf_counters::counter>(c));
+	}
+
+	printf("%-12s %10.3f ms  %6.1f MiB", name, median_ns(samples, runs) / 1e6,
+			lm.memory_bytes() / 1048576.0);
+	for (int c = 0; c < perf_counters::n_counters; c++) {
+		if (misses[c] < 0)
+			printf("  %s n/a", perf_counters::names[c]);
+		else
+			printf("  %s %lld", perf_counters::names[c], misses[c]);
+	}
+	printf("  (answer %d)\n", result.time);
+
+	if (expected < 0) expected = result.time;
+	else if (expected != result.time) mismatch = true;
+
+	delete[] samples;
+	delete copy;
+}
+
+void bench_layouts(const map &m, vertex start, vertex end, int runs) {
+	bench_layout<row_major>("row_major", m, start, end, runs);
+	bench_layout<tiled<8>>("tiled<8>", m, start, end, runs);
+	bench_layout<tiled<16>>("tiled<16>", m, start, end, runs);
+	bench_layout<tiled<32>>("tiled<32>", m, start, end, runs);
+	bench_layout<morton>("morton", m, start, end, runs);
+}
+
+void bench_matrix(int runs) {
+	struct input {
+		const char *name;
+		generator_options opts;
+	};
+
+	auto make = [] (const char *name, int size, height_profile profile, int max_height,
+			int n_lifts, int n_hubs, int max_period) {
+		input in{name, {}};
+		in.opts.width = in.opts.height = size;
+		in.opts.profile = profile;
+		in.opts.max_height = max_height;
+		in.opts.n_lifts = n_lifts;
+		in.opts.n_hubs = n_hubs;
+		in.opts.clustering = 90;
+		in.opts.max_period = max_period;
+		return in;
+	};
+
+	input inputs[] = {
+		make("flat plain", 500, height_profile::flat, 0, 0, 0, 1),
+		make("random heights", 500, height_profile::random, 100, 0, 0, 1),
+		make("sawtooth", 500, height_profile::sawtooth, 1000, 0, 0, 1),
+		make("ridges", 500, height_profile::ridges, 200, 0, 0, 1),
+		make("slope, scattered lifts", 500, height_profile::slope, 500, 2000, 0, 1),
+		make("lift hubs", 300, height_profile::random, 20, 20000, 16, 1),
+		make("timed lift hubs", 300, height_profile::random, 20, 20000, 16, 30),
+	};
+
+	constexpr int n_queries = 5;
+	long long *samples = new long long[runs * n_queries];
+
+	for (auto &in : inputs) {
+		map_generator gen{in.opts};
+		auto t0 = now_ns();
+		map *generated = gen.generate();
+		auto gen_ns = now_ns() - t0;
+		map &m = *generated;
+
+		printf("%s: %dx%d, %d lifts (%d after pruning), generated in %.1f ms\n",
+				in.name, m.width, m.height, m.n_lifts, m.all_lifts().size(), gen_ns / 1e6);
+
+		// The corner to corner query, and some random ones.
+		route_query queries[n_queries];
+		int reference[n_queries];
+		queries[0] = {gen.header().start, gen.header().end};
+
+		lcg rng{42};
+		for (int q = 1; q < n_queries; q++) {
+			queries[q].source = {rng.next(m.width), rng.next(m.height)};
+			queries[q].target = {rng.next(m.width), rng.next(m.height)};
+		}
+
+		for (int q = 0; q < n_queries; q++)
+			reference[q] = dijkstra<pairing_heap>(m, queries[q].source, queries[q].target).time;
+
+		auto run = [&] (const char *name, auto solve) {
+			bool ok = true;
+			int n = 0;
+
+			for (int r = 0; r < runs; r++) {
+				for (int q = 0; q < n_queries; q++) {
+					auto t0 = now_ns();
+					auto result = solve(queries[q].source, queries[q].target);
+					samples[n++] = now_ns() - t0;
+
+					if (result.time != reference[q]) ok = false;
+				}
+			}
+
+			if (!ok) mismatch = true;
+
+			auto median = percentile_ns(samples, n, 50);
+			auto p99 = percentile_ns(samples, n, 99);
+			printf("  %-22s median %10.3f ms  p99 %10.3f ms  %s\n",
+					name, median / 1e6, p99 / 1e6, ok ? "ok" : "MISMATCH");
+		};
+
+		run("pairing_heap", [&] (vertex s, vertex t) { return dijkstra<pairing_heap>(m, s, t); });
+		run("indexed_pairing_heap", [&] (vertex s, vertex t) {
+			return dijkstra<indexed_pairing_heap>(m, s, t);
+		});
+		run("dary_heap<2>", [&] (vertex s, vertex t) { return dijkstra<dary_heap<2>>(m, s, t); });
+		run("dary_heap<4>", [&] (vertex s, vertex t) { return dijkstra<dary_heap<4>>(m, s, t); });
+		run("dary_heap<8>", [&] (vertex s, vertex t) { return dijkstra<dary_heap<8>>(m, s, t); });
+		run("radix_heap", [&] (vertex s, vertex t) { return dijkstra<radix_heap>(m, s, t); });
+		run("dial", [&] (vertex s, vertex t) { return dial(m, s, t); });
+
+		if (compact_graph::fits(m)) {
+			compact_graph g{m};
+			run("radix_heap (compact)", [&] (vertex s, vertex t) { return dijkstra<radix_heap>(g, s, t); });
+			run("dial (compact)", [&] (vertex s, vertex t) { return dial(g, s, t); });
+		}
+
+		auto tiled_map = copy_map<tiled<16>>(m);
+		run("radix_heap (tiled<16>)", [&] (vertex s, vertex t) { return dijkstra<radix_heap>(*tiled_map, s, t); });
+		delete tiled_map;
+
+		auto morton_map = copy_map<morton>(m);
+		run("radix_heap (morton)", [&] (vertex s, vertex t) { return dijkstra<radix_heap>(*morton_map, s, t); });
+		delete morton_map;
+
+		run("astar (lift-aware)", [&] (vertex s, vertex t) { return astar<lift_heuristic>(m, s, t); });
+		run("bidirectional", [&] (vertex s, vertex t) { return bidirectional(m, s, t); });
+
+		landmarks l{m, 4};
+		alt_router<> ar{m, l};
+		run("alt, 4 landmarks", [&] (vertex s, vertex t) { return ar.route(s, t); });
+
+		delete generated;
+	}
+
+	delete[] samples;
+}
+
+void bench_delta(int runs) {
+	struct input {
+		const char *name;
+		generator_options opts;
+	};
+
+	auto make = [] (const char *name, height_profile profile, int max_height,
+			int n_lifts, int n_hubs, int max_period) {
+		input in{name, {}};
+		in.opts.width = in.opts.height = 1000;
+		in.opts.profile = profile;
+		in.opts.max_height = max_height;
+		in.opts.n_lifts = n_lifts;
+		in.opts.n_hubs = n_hubs;
+		in.opts.clustering = 90;
+		in.opts.max_period = max_period;
+		return in;
+	};
+
+	input inputs[] = {
+		make("flat plain", height_profile::flat, 0, 0, 0, 1),
+		make("random heights", height_profile::random, 100, 0, 0, 1),
+		make("slope, scattered lifts", height_profile::slope, 500, 5000, 0, 1),
+		make("timed lift hubs", height_profile::random, 20, 20000, 16, 30),
+	};
+
+	int deltas[] = {1, 4, 16, 64, 256};
+
+	int n_cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+	if (n_cpus < 1) n_cpus = 1;
+
+	long long *samples = new long long[runs];
+
+	for (auto &in : inputs) {
+		map_generator gen{in.opts};
+		map *generated = gen.generate();
+		map &m = *generated;
+		vertex start = gen.header().start, end = gen.header().end;
+
+		int reference = 0;
+		for (int i = 0; i < runs; i++) {
+			auto t0 = now_ns();
+			reference = dijkstra<radix_heap>(m, start, end).time;
+			samples[i] = now_ns() - t0;
+		}
+
+		auto base = median_ns(samples, runs);
+		printf("%s: %dx%d, %d lifts, max edge %d, radix_heap %.3f ms\n",
+				in.name, m.width, m.height, m.n_lifts, m.max_edge(), base / 1e6);
+
+		for (int n_threads = 1; ; n_threads = n_threads * 2 < n_cpus ? n_threads * 2 : n_cpus) {
+			thread_pool pool{n_threads};
+
+			for (int delta : deltas) {
+				delta_stepping_router<> r{m, pool, delta};
+				bool ok = true;
+
+				for (int i = 0; i < runs; i++) {
+					auto t0 = now_ns();
+					auto result = r.route(start, end);
+					samples[i] = now_ns() - t0;
+
+					if (result.time != reference) ok = false;
+				}
+
+				if (!ok) mismatch = true;
+
+				auto median = median_ns(samples, runs);
+				printf("  %3d threads, delta %4d %10.3f ms %8.2fx  %s\n", n_threads, r.delta(),
+						median / 1e6, static_cast<double>(base) / median, ok ? "ok" : "MISMATCH");
+			}
+
+			if (n_threads == n_cpus) break;
+		}
+
+		delete generated;
+	}
+
+	delete[] samples;
+}
+
+} // namespace anonymous
+
+int main(int argc, char **argv) {
+	const char *suite = "queues";
+	int arg = 1;
+
+	if (arg < argc && (argv[arg][0] < '0' || argv[arg][0] > '9'))
+		suite = argv[arg++];
+
+	if (strcmp(suite, "queues") && strcmp(suite, "threads") && strcmp(suite, "compact")
+			&& strcmp(suite, "kernel") && strcmp(suite, "layout") && strcmp(suite, "alt")
+			&& strcmp(suite, "profile") && strcmp(suite, "incremental") && strcmp(suite, "matrix")
+			&& strcmp(suite, "delta")) {
+		fprintf(stderr, "usage: %s [queues | threads | compact | kernel | layout | alt | profile | incremental]"
+				" [runs] < map\n"
+				"       %s matrix | delta [runs]\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	int runs = arg < argc ? atoi(argv[arg]) : 5;
+	if (runs < 1) runs = 1;
+
+	if (!strcmp(suite, "matrix") || !strcmp(suite, "delta")) {
+		if (!strcmp(suite, "matrix")) bench_matrix(runs);
+		else bench_delta(runs);
+
+		if (mismatch) {
+			fprintf(stderr, "some answers differ from the reference\n");
+			return 1;
+		}
+		return 0;
+	}
+
+	input_reader in;
+	map_header header;
+	if (!header.read(in)) {
+		fprintf(stderr, "missing or malformed map header\n");
+		return 1;
+	}
+
+	int width = header.width, height = header.height, n_lifts = header.n_lifts;
+	vertex start = header.start, end = header.end;
+
+	map m{width, height, n_lifts};
+	m.read_lifts(in);
+	m.read_heights(in);
+
+	printf("%dx%d map, %d lifts (%d after pruning), %d runs each\n",
+			width, height, n_lifts, m.all_lifts().size(), runs);
+
+	if (!strcmp(suite, "threads"))
+		bench_threads(m, runs);
+	else if (!strcmp(suite, "compact"))
+		bench_compact(m, start, end, runs);
+	else if (!strcmp(suite, "kernel"))
+		bench_kernel(m, runs);
+	else if (!strcmp(suite, "layout"))
+		bench_layouts(m, start, end, runs);
+	else if (!strcmp(suite, "alt"))
+		bench_alt(m, runs);
+	else if (!strcmp(suite, "profile"))
+		bench_profile(m, runs);
+	else if (!strcmp(suite, "incremental"))
+		bench_incremental(m, start, end, runs);
+	else
+		bench_queues(m, start, end, runs);
+
+	if (mismatch) {
+		fprintf(stderr, "error: results disagree\n");
+		return 1;
+	}
+}
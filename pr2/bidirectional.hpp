@@ -0,0 +1,86 @@
+#pragma once
+
+#include <climits>
+
+#include "astar.hpp"
+#include "containers.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "stats.hpp"
+#include "types.hpp"
+
+// Bidirectional Dijkstra's algorithm, running one search forwards from the
+// source and one backwards from the target, always advancing the one with
+// the smaller minimum. Every relaxation that touches a vertex reached by
+// the other side is a candidate path, and the search stops once the two
+// minimums together can't beat the best candidate.
+//
+// The backward search needs the edge weights without knowing the time at
+// which an edge is entered, which is impossible with timed lifts, so such
+// maps fall back to A* with the lift-aware heuristic.
+template <typename Queue = dary_heap<4>>
+search_result bidirectional(const map &m, vertex source, vertex target) {
+	if (m.has_timed_lifts())
+		return astar<lift_heuristic, Queue>(m, source, target);
+
+	array2d<int> dist_fwd{m.width, m.height};
+	array2d<int> dist_bwd{m.width, m.height};
+	Queue Q_fwd, Q_bwd;
+	fixed_vector<neighbor> neighbors{4 + m.n_lifts};
+	int settled = 0;
+
+	for (int i = 0; i < m.width * m.height; i++) {
+		dist_fwd.data[i] = INT_MAX;
+		dist_bwd.data[i] = INT_MAX;
+	}
+
+	dist_fwd[source] = 0;
+	dist_bwd[target] = 0;
+	Q_fwd.insert(0, source);
+	Q_bwd.insert(0, target);
+	stats::queue_cleared();
+	stats::pushed(2);
+
+	int best = source == target ? 0 : INT_MAX;
+
+	auto advance = [&] (Queue &Q, array2d<int> &dist, array2d<int> &other, bool forwards) {
+		auto [priority, u] = Q.extract_min();
+		stats::popped(priority > dist[u]);
+		if (priority > dist[u]) return;
+
+		settled++;
+
+		if (forwards)
+			m.compute_neighbors(dist[u], u, neighbors);
+		else
+			m.compute_reverse_neighbors(u, neighbors);
+		stats::relaxed(neighbors.size());
+
+		for (auto [v, edge] : neighbors) {
+			auto alt = dist[u] + edge;
+
+			if (alt < dist[v]) {
+				dist[v] = alt;
+				bool added = Q.insert(alt, v);
+				stats::inserted(added);
+			}
+
+			if (other[v] != INT_MAX && alt + other[v] < best)
+				best = alt + other[v];
+		}
+	};
+
+	while (!Q_fwd.empty() && !Q_bwd.empty()) {
+		int min_fwd = Q_fwd.min_priority();
+		int min_bwd = Q_bwd.min_priority();
+		if (best != INT_MAX && min_fwd + min_bwd >= best) break;
+
+		if (min_fwd <= min_bwd)
+			advance(Q_fwd, dist_fwd, dist_bwd, true);
+		else
+			advance(Q_bwd, dist_bwd, dist_fwd, false);
+	}
+
+	return {best, settled};
+}
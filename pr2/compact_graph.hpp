@@ -0,0 +1,156 @@
+#pragma once
+
+#include <climits>
+
+#include "containers.hpp"
+#include "cost_kernel.hpp"
+#include "dijkstra.hpp"
+#include "map.hpp"
+#include "stats.hpp"
+#include "types.hpp"
+
+// The map's edges, precomputed once so that searches don't have to
+// recompute them on every pop. Grid edge costs are stored as four 16-bit
+// integers per cell (see grid_costs), computed by compute_grid_costs, and
+// the lifts are stored in compressed sparse row form: the lifts leaving
+// cell i are lift_edges_[lift_offsets_[i] ... lift_offsets_[i + 1]). Lift
+// waits still depend on the arrival time, so they are computed on the fly
+// from the stored period.
+// Can be used in place of map by dijkstra(), dial(), router and batch_route().
+struct compact_graph {
+	using layout = row_major;
+
+	explicit compact_graph(const map &m)
+	: width{m.width}, height{m.height}, n_lifts{m.n_lifts}
+	, max_edge_{m.max_edge()}, grid_{m.width, m.height}
+	, lift_offsets_{new int[m.width * m.height + 1]}
+	, lift_edges_{new lift_edge[m.all_lifts().size()]} {
+		compute_grid_costs(m.heights.data, width, height, grid_.data);
+
+		// The map's lifts are already grouped by origin in row-major order.
+		int n = 0;
+		for (int i = 0; i < width * height; i++) {
+			lift_offsets_[i] = n;
+
+			for (auto l : m.lifts_from({i % width, i / width}))
+				lift_edges_[n++] = {l.to, l.leaves_every, l.travel_time};
+		}
+		lift_offsets_[width * height] = n;
+	}
+
+	compact_graph(const compact_graph &other) = delete;
+	compact_graph(compact_graph &&other) = delete;
+	compact_graph &operator=(const compact_graph &other) = delete;
+	compact_graph &operator=(compact_graph &&other) = delete;
+
+	~compact_graph() {
+		delete[] lift_offsets_;
+		delete[] lift_edges_;
+	}
+
+	// Whether every grid edge cost of the map fits into 16 bits.
+	static bool fits(const map &m) {
+		return m.max_grid_edge() <= 0xFFFF;
+	}
+
+	int max_edge() const {
+		return max_edge_;
+	}
+
+	// Same as map::compute_neighbors.
+	void compute_neighbors(int time, vertex from, fixed_vector<neighbor> &out) const {
+		auto costs = grid_[from];
+		out.clear();
+
+		if (costs.left) out.push({{from.x - 1, from.y}, costs.left});
+		if (costs.right) out.push({{from.x + 1, from.y}, costs.right});
+		if (costs.up) out.push({{from.x, from.y - 1}, costs.up});
+		if (costs.down) out.push({{from.x, from.y + 1}, costs.down});
+
+		int i = from.x + width * from.y;
+		stats::lift_edges(lift_offsets_[i + 1] - lift_offsets_[i]);
+		for (int j = lift_offsets_[i]; j < lift_offsets_[i + 1]; j++) {
+			auto l = lift_edges_[j];
+			out.push({l.to, lift::wait(l.leaves_every, time) + l.travel_time});
+		}
+	}
+
+	// Relaxes the four grid edges without branching on whether they exist
+	// or improve anything, except to decide whether to insert into the
+	// queue. A missing edge is turned into a self-loop of infinite cost,
+	// which can never improve anything, so its distance is just rewritten
+	// as it was. Lift edges are relaxed as usual.
+	template <typename Queue>
+	void relax_edges(vertex u, int dist_u, search_state<Queue, layout> &state) const {
+		auto &dist = state.dist;
+		auto costs = grid_[u];
+
+		auto relax = [&] (unsigned short cost, vertex to) {
+			vertex v = cost ? to : u;
+			int alt = cost ? dist_u + cost : INT_MAX;
+			int old = dist[v];
+			bool improved = alt < old;
+
+			dist.set(v, improved ? alt : old);
+			return improved ? v : vertex{-1, -1};
+		};
+
+		// Insert only after all four are relaxed, so the branches on the
+		// result don't get in between the loads and stores.
+		vertex v0 = relax(costs.left, {u.x - 1, u.y});
+		vertex v1 = relax(costs.right, {u.x + 1, u.y});
+		vertex v2 = relax(costs.up, {u.x, u.y - 1});
+		vertex v3 = relax(costs.down, {u.x, u.y + 1});
+
+		int added = 0;
+		if (v0.x >= 0) added += state.Q.insert(dist_u + costs.left, v0);
+		if (v1.x >= 0) added += state.Q.insert(dist_u + costs.right, v1);
+		if (v2.x >= 0) added += state.Q.insert(dist_u + costs.up, v2);
+		if (v3.x >= 0) added += state.Q.insert(dist_u + costs.down, v3);
+		stats::pushed(added);
+		stats::decreased((v0.x >= 0) + (v1.x >= 0) + (v2.x >= 0) + (v3.x >= 0) - added);
+
+		int i = u.x + width * u.y;
+		int n_lifts = lift_offsets_[i + 1] - lift_offsets_[i];
+		// Missing grid edges count too, they're relaxed all the same.
+		stats::relaxed(4 + n_lifts);
+		stats::lift_edges(n_lifts);
+		for (int j = lift_offsets_[i]; j < lift_offsets_[i + 1]; j++) {
+			auto l = lift_edges_[j];
+			int alt = dist_u + lift::wait(l.leaves_every, dist_u) + l.travel_time;
+
+			if (alt < dist[l.to]) {
+				dist.set(l.to, alt);
+				bool added = state.Q.insert(alt, l.to);
+				stats::inserted(added);
+			}
+		}
+	}
+
+	long long memory_bytes() const {
+		long long cells = static_cast<long long>(width) * height;
+		return cells * sizeof(grid_costs)
+			+ (cells + 1) * sizeof(int)
+			+ static_cast<long long>(lift_offsets_[cells]) * sizeof(lift_edge);
+	}
+
+	const int width, height;
+	const int n_lifts;
+
+private:
+	struct lift_edge {
+		vertex to;
+		int leaves_every;
+		int travel_time;
+	};
+
+	const int max_edge_;
+	array2d<grid_costs> grid_;
+	int *const lift_offsets_;
+	lift_edge *const lift_edges_;
+};
+
+template <typename Queue>
+void relax_edges(const compact_graph &g, vertex u, int dist_u, search_state<Queue, row_major> &state) {
+	g.relax_edges(u, dist_u, state);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "layout.hpp"
+#include "types.hpp"
+
+// Layout decides where each vertex is stored (see layout.hpp). Only with
+// the default row_major layout is data[x + width * y] the same as
+// (*this)[{x, y}], other layouts may also have padding, so size can be
+// larger than width * height.
+template <typename T, typename Layout = row_major>
+struct array2d {
+	array2d(int width, int height)
+	: width{width}, height{height}
+	, layout{width, height}, size{layout.size(width, height)}
+	, data{new T[size]{}} { }
+
+	array2d(const array2d &other) = delete;
+	array2d(array2d &&other) = delete;
+	array2d &operator=(const array2d &other) = delete;
+	array2d &operator=(array2d &&other) = delete;
+
+	~array2d() {
+		delete[] data;
+	}
+
+	T &operator[](vertex vtx) const {
+		return data[layout(vtx)];
+	}
+
+	const int width, height;
+	const Layout layout;
+	const int size;
+	T *const data;
+};
+
+template <typename T>
+struct fixed_vector {
+	explicit fixed_vector(int capacity)
+	: capacity_{capacity}, data_{new T[capacity]} { }
+
+	fixed_vector(const fixed_vector &other) = delete;
+	fixed_vector(fixed_vector &&other) = delete;
+	fixed_vector &operator=(const fixed_vector &other) = delete;
+	fixed_vector &operator=(fixed_vector &&other) = delete;
+
+	~fixed_vector() {
+		delete[] data_;
+	}
+
+	int size() const {
+		return size_;
+	}
+
+	void push(const T &t) {
+		data_[size_++] = t;
+	}
+
+	void clear() {
+		size_ = 0;
+	}
+
+	T *begin() const {
+		return data_;
+	}
+
+	T *end() const {
+		return data_ + size_;
+	}
+
+private:
+	const int capacity_;
+	int size_ = 0;
+	T *const data_;
+};
+
+// Like fixed_vector, but doubles its capacity when full.
+// Only meant for trivially copyable T.
+template <typename T>
+struct dynamic_vector {
+	dynamic_vector() = default;
+
+	dynamic_vector(const dynamic_vector &other) = delete;
+	dynamic_vector(dynamic_vector &&other) = delete;
+	dynamic_vector &operator=(const dynamic_vector &other) = delete;
+	dynamic_vector &operator=(dynamic_vector &&other) = delete;
+
+	~dynamic_vector() {
+		delete[] data_;
+	}
+
+	int size() const {
+		return size_;
+	}
+
+	bool empty() const {
+		return !size_;
+	}
+
+	void push(const T &t) {
+		if (size_ == capacity_)
+			grow_();
+		data_[size_++] = t;
+	}
+
+	T pop() {
+		return data_[--size_];
+	}
+
+	void clear() {
+		size_ = 0;
+	}
+
+	T &operator[](int i) const {
+		return data_[i];
+	}
+
+	T *begin() const {
+		return data_;
+	}
+
+	T *end() const {
+		return data_ + size_;
+	}
+
+private:
+	void grow_() {
+		int new_capacity = capacity_ ? capacity_ * 2 : 16;
+		T *new_data = new T[new_capacity];
+
+		for (int i = 0; i < size_; i++)
+			new_data[i] = data_[i];
+
+		delete[] data_;
+		data_ = new_data;
+		capacity_ = new_capacity;
+	}
+
+	int capacity_ = 0;
+	int size_ = 0;
+	T *data_ = nullptr;
+};
+
+// In-place heap sort by less, for when the items can be many and no extra
+// memory should be needed.
+template <typename T, typename Less>
+void heap_sort(T *items, int n, Less less) {
+	auto sift_down = [&] (int i, int n) {
+		for (int child; (child = 2 * i + 1) < n; i = child) {
+			if (child + 1 < n && less(items[child], items[child + 1])) child++;
+			if (!less(items[i], items[child])) break;
+
+			T tmp = items[i];
+			items[i] = items[child];
+			items[child] = tmp;
+		}
+	};
+
+	for (int i = n / 2 - 1; i >= 0; i--) sift_down(i, n);
+
+	for (int end = n - 1; end > 0; end--) {
+		T tmp = items[0];
+		items[0] = items[end];
+		items[end] = tmp;
+
+		sift_down(0, end);
+	}
+}
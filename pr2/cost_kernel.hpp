@@ -0,0 +1,156 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PR2_X86_KERNELS 1
+#endif
+
+// Costs of the four grid edges leaving a cell, 0 meaning that there is no
+// edge in that direction (the cell is on the border of the map). Every
+// actual edge costs at least 1, so 0 is never a valid cost.
+struct grid_costs {
+	unsigned short left, right, up, down;
+};
+
+// The cost of moving from height B to height A, as in map::compute_neighbors.
+inline int grid_cost(int A, int B) {
+	return A > B ? A - B + 1 : 1;
+}
+
+namespace cost_kernel {
+
+// Computes the costs of a single cell, checking for the map borders.
+inline grid_costs cell(const int *heights, int width, int height, int x, int y) {
+	const int *at = heights + x + width * y;
+	int B = *at;
+
+	return {
+		static_cast<unsigned short>(x > 0 ? grid_cost(at[-1], B) : 0),
+		static_cast<unsigned short>(x < width - 1 ? grid_cost(at[1], B) : 0),
+		static_cast<unsigned short>(y > 0 ? grid_cost(at[-width], B) : 0),
+		static_cast<unsigned short>(y < height - 1 ? grid_cost(at[width], B) : 0),
+	};
+}
+
+// The vector versions below only handle cells with all four neighbors, and
+// return the x at which they stopped, leaving the rest of the row to cell().
+
+#ifdef PR2_X86_KERNELS
+__attribute__((target("sse4.1")))
+inline __m128i cost_sse41(__m128i A, __m128i B) {
+	return _mm_add_epi32(_mm_max_epi32(_mm_sub_epi32(A, B), _mm_setzero_si128()), _mm_set1_epi32(1));
+}
+
+__attribute__((target("sse4.1")))
+inline int row_sse41(const int *row, int width, grid_costs *out) {
+	auto load = [] (const int *p) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	};
+
+	int x = 1;
+	for (; x + 4 <= width - 1; x += 4) {
+		const int *at = row + x;
+		__m128i B = load(at);
+
+		__m128i L = cost_sse41(load(at - 1), B);
+		__m128i R = cost_sse41(load(at + 1), B);
+		__m128i U = cost_sse41(load(at - width), B);
+		__m128i D = cost_sse41(load(at + width), B);
+
+		// Transpose from one vector per direction to one
+		// (left, right, up, down) quadruple per cell.
+		__m128i LR = _mm_packus_epi32(_mm_unpacklo_epi32(L, R), _mm_unpackhi_epi32(L, R));
+		__m128i UD = _mm_packus_epi32(_mm_unpacklo_epi32(U, D), _mm_unpackhi_epi32(U, D));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_unpacklo_epi32(LR, UD));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x + 2), _mm_unpackhi_epi32(LR, UD));
+	}
+
+	return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i cost_avx2(__m256i A, __m256i B) {
+	return _mm256_add_epi32(_mm256_max_epi32(_mm256_sub_epi32(A, B), _mm256_setzero_si256()),
+			_mm256_set1_epi32(1));
+}
+
+__attribute__((target("avx2")))
+inline __m256i load_avx2(const int *p) {
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+__attribute__((target("avx2")))
+inline int row_avx2(const int *row, int width, grid_costs *out) {
+	int x = 1;
+	for (; x + 8 <= width - 1; x += 8) {
+		const int *at = row + x;
+		__m256i B = load_avx2(at);
+
+		__m256i L = cost_avx2(load_avx2(at - 1), B);
+		__m256i R = cost_avx2(load_avx2(at + 1), B);
+		__m256i U = cost_avx2(load_avx2(at - width), B);
+		__m256i D = cost_avx2(load_avx2(at + width), B);
+
+		// Same transpose as in row_sse41, but the AVX2 unpacks and packs
+		// work within 128-bit lanes, so the first vector ends up with
+		// cells 0, 1, 4, 5 and the second with 2, 3, 6, 7.
+		__m256i LR = _mm256_packus_epi32(_mm256_unpacklo_epi32(L, R), _mm256_unpackhi_epi32(L, R));
+		__m256i UD = _mm256_packus_epi32(_mm256_unpacklo_epi32(U, D), _mm256_unpackhi_epi32(U, D));
+		__m256i lo = _mm256_unpacklo_epi32(LR, UD);
+		__m256i hi = _mm256_unpackhi_epi32(LR, UD);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x),
+				_mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x + 4),
+				_mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	return x;
+}
+#endif
+
+enum class isa {
+	scalar,
+	sse41,
+	avx2,
+};
+
+inline isa best_isa() {
+#ifdef PR2_X86_KERNELS
+	if (__builtin_cpu_supports("avx2")) return isa::avx2;
+	if (__builtin_cpu_supports("sse4.1")) return isa::sse41;
+#endif
+	return isa::scalar;
+}
+
+} // namespace cost_kernel
+
+// Computes the grid_costs of every cell of a row-major height map in one
+// pass, using the widest vector instructions the CPU supports. All costs
+// must fit into 16 bits (see compact_graph::fits), since the vector
+// versions saturate them.
+inline void compute_grid_costs(const int *heights, int width, int height, grid_costs *out,
+		cost_kernel::isa isa = cost_kernel::best_isa()) {
+	static_cast<void>(isa); // Unused without the x86 kernels.
+
+	for (int y = 0; y < height; y++) {
+		const int *row = heights + width * y;
+		grid_costs *row_out = out + width * y;
+		int x = 0;
+
+		// The first and last rows are missing a neighbor, and so are the
+		// first and last columns, which the vector versions skip.
+#ifdef PR2_X86_KERNELS
+		if (y > 0 && y < height - 1 && isa != cost_kernel::isa::scalar) {
+			row_out[0] = cost_kernel::cell(heights, width, height, 0, y);
+			x = isa == cost_kernel::isa::avx2
+				? cost_kernel::row_avx2(row, width, row_out)
+				: cost_kernel::row_sse41(row, width, row_out);
+		}
+#endif
+
+		for (; x < width; x++)
+			row_out[x] = cost_kernel::cell(heights, width, height, x, y);
+	}
+}
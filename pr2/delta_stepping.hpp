@@ -0,0 +1,280 @@
+#pragma once
+
+#include <climits>
+
+#include "containers.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+// Parallel single query search with delta-stepping, see:
+// Meyer, Sanders - Delta-stepping: a parallelizable shortest path
+// algorithm (2003)
+//
+// Vertices wait in buckets of arrival times delta wide. The whole lowest
+// bucket is taken at once and spread over the threads, which relax the
+// light edges (taking at most delta) of what they took, refilling the
+// bucket, until it stays empty. Then they relax the heavy edges of
+// everything that was in it, which can only lead to later buckets. A
+// vertex can be taken from the same bucket more than once as its arrival
+// time improves, so unlike dijkstra() this corrects labels rather than
+// settling them, and lands on the same arrival times: leaving a vertex
+// sooner never arrives anywhere later, waiting for lifts included.
+//
+// Every thread pushes only to buckets of its own. The entries taken from
+// them are claimed in chunks through an atomic cursor, by their own thread
+// first and then by the others once it runs out of its own, so the work
+// evens out between the threads. Arrival times are lowered with a compare
+// and swap, and only the thread that lowered one pushes the vertex.
+template <typename Graph = map>
+struct delta_stepping_router {
+	// The delta is raised if the buckets for it would take up more than
+	// dial_max_buckets, see delta().
+	delta_stepping_router(const Graph &g, thread_pool &pool, int delta)
+	: g_{g}, pool_{pool}, delta_{fit_delta_(g.max_edge(), delta)}
+	, n_buckets_{g.max_edge() / delta_ + 2}, dist_{g.width, g.height}
+	, workers_{new worker[pool.size()]}, barrier_{pool.size()} {
+		for (int i = 0; i < pool.size(); i++) {
+			workers_[i].buckets = new dynamic_vector<queue_entry>[n_buckets_];
+			workers_[i].neighbors = new fixed_vector<neighbor>{4 + g.n_lifts};
+		}
+	}
+
+	delta_stepping_router(const delta_stepping_router &other) = delete;
+	delta_stepping_router(delta_stepping_router &&other) = delete;
+	delta_stepping_router &operator=(const delta_stepping_router &other) = delete;
+	delta_stepping_router &operator=(delta_stepping_router &&other) = delete;
+
+	~delta_stepping_router() {
+		for (int i = 0; i < pool_.size(); i++) {
+			delete[] workers_[i].buckets;
+			delete workers_[i].neighbors;
+		}
+
+		delete[] workers_;
+	}
+
+	int delta() const {
+		return delta_;
+	}
+
+	// Settled counts the vertices taken from the buckets with their
+	// current arrival time, which can count a vertex more than once.
+	search_result route(vertex source, vertex target) {
+		reset_dist_();
+		lower_(source, 0);
+
+		bucket_ = 0;
+		done_ = false;
+		work_[0] = work_[1] = 0;
+
+		auto job = [&] (int self) { run_(self, source, target); };
+		pool_.run(job);
+
+		int settled = 0;
+		for (int i = 0; i < pool_.size(); i++)
+			settled += workers_[i].n_settled;
+
+		return {arrival_at_(target), settled};
+	}
+
+private:
+	struct alignas(64) worker {
+		// Cyclic, arrival time t goes to t / delta % n_buckets.
+		dynamic_vector<queue_entry> *buckets = nullptr;
+		// Taken from the current bucket for this round of light edges,
+		// and how far the threads have claimed it.
+		dynamic_vector<queue_entry> taken;
+		int taken_claimed = 0;
+		// Taken from the current bucket so far and left with heavy edges.
+		dynamic_vector<queue_entry> settled;
+		int settled_claimed = 0;
+
+		fixed_vector<neighbor> *neighbors = nullptr;
+		int n_settled = 0;
+	};
+
+	// Entries claimed at once, a few cache lines of them.
+	static constexpr int claim_chunk = 32;
+
+	static int fit_delta_(int max_edge, int delta) {
+		if (delta < 1) delta = 1;
+		if (max_edge / delta + 2 > dial_max_buckets)
+			delta = max_edge / (dial_max_buckets - 2) + 1;
+		return delta;
+	}
+
+	void run_(int self, vertex source, vertex target) {
+		auto &me = workers_[self];
+		me.n_settled = 0;
+		me.settled.clear();
+		// Entries left over from a search that stopped at its target.
+		for (int i = 0; i < n_buckets_; i++)
+			me.buckets[i].clear();
+		if (!self) me.buckets[0].push({0, source});
+
+		int round = 0;
+
+		while (true) {
+			me.settled_claimed = 0;
+
+			// Light edges, until the bucket stays empty.
+			while (true) {
+				auto &bucket = me.buckets[bucket_ % n_buckets_];
+				me.taken.clear();
+				for (auto e : bucket) me.taken.push(e);
+				bucket.clear();
+				me.taken_claimed = 0;
+
+				__atomic_add_fetch(&work_[round & 1], me.taken.size(), __ATOMIC_RELAXED);
+				barrier_.wait();
+				if (!__atomic_load_n(&work_[round & 1], __ATOMIC_RELAXED)) break;
+
+				// Nobody reads the other counter until the next round, and
+				// nobody adds to it before the barrier below.
+				if (!self) work_[(round + 1) & 1] = 0;
+				round++;
+
+				claim_(self, &worker::taken, &worker::taken_claimed, [&] (queue_entry e) {
+					auto [arrival, u] = e;
+					if (arrival_at_(u) != arrival) return;
+
+					me.n_settled++;
+					if (relax_(me, u, arrival, true)) me.settled.push(e);
+				});
+
+				barrier_.wait();
+			}
+
+			// Heavy edges, of the vertices that kept the arrival time they
+			// were taken with.
+			claim_(self, &worker::settled, &worker::settled_claimed, [&] (queue_entry e) {
+				auto [arrival, u] = e;
+				if (arrival_at_(u) != arrival) return;
+
+				relax_(me, u, arrival, false);
+			});
+
+			barrier_.wait();
+			me.settled.clear();
+			if (!self) next_bucket_(target);
+			barrier_.wait();
+
+			if (done_) break;
+		}
+	}
+
+	// Calls f for every entry in the given list of every worker, claiming
+	// them in chunks, starting with the worker's own.
+	template <typename F>
+	void claim_(int self, dynamic_vector<queue_entry> worker::*list, int worker::*claimed, F f) {
+		int n = pool_.size();
+
+		for (int k = 0; k < n; k++) {
+			auto &w = workers_[(self + k) % n];
+			auto &entries = w.*list;
+			int size = entries.size();
+
+			while (true) {
+				int i = __atomic_fetch_add(&(w.*claimed), claim_chunk, __ATOMIC_RELAXED);
+				if (i >= size) break;
+
+				int end = i + claim_chunk < size ? i + claim_chunk : size;
+				for (; i < end; i++) f(entries[i]);
+			}
+		}
+	}
+
+	// Relaxes either the light or the heavy edges leaving u at the given
+	// time, returns whether it skipped any of the others.
+	bool relax_(worker &me, vertex u, int time, bool light) {
+		auto &neighbors = *me.neighbors;
+		g_.compute_neighbors(time, u, neighbors);
+		bool skipped = false;
+
+		for (auto [v, edge] : neighbors) {
+			if ((edge <= delta_) != light) {
+				skipped = true;
+				continue;
+			}
+
+			int arrival = time + edge;
+			if (lower_(v, arrival))
+				me.buckets[arrival / delta_ % n_buckets_].push({arrival, v});
+		}
+
+		return skipped;
+	}
+
+	// Once the current bucket is done, every arrival time before the next
+	// non-empty one is final, so the search can stop if the target's is.
+	void next_bucket_(vertex target) {
+		int n = pool_.size();
+		long long target_arrival = arrival_at_(target);
+
+		for (int b = bucket_ + 1; b < bucket_ + n_buckets_; b++) {
+			for (int i = 0; i < n; i++) {
+				if (workers_[i].buckets[b % n_buckets_].empty()) continue;
+
+				bucket_ = b;
+				done_ = target_arrival < static_cast<long long>(b) * delta_;
+				return;
+			}
+		}
+
+		done_ = true;
+	}
+
+	// Entries hold the epoch of the search that wrote them in the upper
+	// half and the arrival time in the lower, like distance_table does, so
+	// that both are swapped at once.
+	int read_(unsigned long long entry) const {
+		return entry >> 32 == epoch_ ? static_cast<int>(entry & 0xFFFFFFFF) : INT_MAX;
+	}
+
+	int arrival_at_(vertex v) const {
+		return read_(__atomic_load_n(&dist_[v], __ATOMIC_RELAXED));
+	}
+
+	// Lowers the arrival time at v, returns whether it was lower.
+	bool lower_(vertex v, int arrival) {
+		auto &entry = dist_[v];
+		unsigned long long seen = __atomic_load_n(&entry, __ATOMIC_RELAXED);
+		unsigned long long lowered = static_cast<unsigned long long>(epoch_) << 32
+			| static_cast<unsigned int>(arrival);
+
+		do {
+			if (arrival >= read_(seen)) return false;
+		} while (!__atomic_compare_exchange_n(&entry, &seen, lowered, true,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+		return true;
+	}
+
+	void reset_dist_() {
+		if (++epoch_) return;
+
+		for (int i = 0; i < dist_.size; i++)
+			dist_.data[i] = 0;
+		epoch_ = 1;
+	}
+
+	const Graph &g_;
+	thread_pool &pool_;
+	const int delta_;
+	const int n_buckets_;
+	// Starts out zeroed, so everything reads as INT_MAX in the first epoch.
+	array2d<unsigned long long, typename Graph::layout> dist_;
+	unsigned int epoch_ = 0;
+
+	worker *const workers_;
+	spin_barrier barrier_;
+
+	// Written by thread 0 between barriers.
+	int bucket_ = 0;
+	bool done_ = false;
+	// Entries taken in a round of light edges, alternating between rounds.
+	int work_[2];
+};
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <climits>
+
+#include "containers.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "stats.hpp"
+#include "types.hpp"
+
+struct search_result {
+	int time;
+	// Number of vertices taken off the queue with their final distance,
+	// not counting outdated duplicate entries.
+	int settled;
+};
+
+// Distances from the source of a search, which can be reused by many
+// searches without resetting all of it in between. Entries are stamped with
+// the epoch of the search that wrote them, and any entry with an older
+// stamp reads as INT_MAX, so reset() only has to bump the epoch.
+// Layout is the same as that of the searched graph.
+template <typename Layout = row_major>
+struct distance_table {
+	distance_table(int width, int height)
+	: entries_{width, height} { }
+
+	void reset() {
+		if (++epoch_) return;
+
+		// The epoch wrapped around, so ancient stamps could be mistaken
+		// for current ones.
+		for (int i = 0; i < entries_.size; i++)
+			entries_.data[i].epoch = 0;
+		epoch_ = 1;
+	}
+
+	int operator[](vertex v) const {
+		auto &e = entries_[v];
+		return e.epoch == epoch_ ? e.dist : INT_MAX;
+	}
+
+	void set(vertex v, int dist) {
+		entries_[v] = {dist, epoch_};
+	}
+
+private:
+	struct entry {
+		int dist;
+		unsigned int epoch;
+	};
+
+	// Starts out zeroed, so everything reads as INT_MAX in the first epoch.
+	array2d<entry, Layout> entries_;
+	unsigned int epoch_ = 1;
+};
+
+// Everything a search writes to, besides the result. Keeping one of these
+// around lets consecutive searches reuse the memory, and giving one to
+// each thread lets them search the same map concurrently. Dist can be
+// anything with the interface of distance_table, like the narrower tables
+// of lean_map.hpp.
+template <typename Queue, typename Layout = row_major, typename Dist = distance_table<Layout>>
+struct search_state {
+	template <typename Graph, typename... Args>
+	explicit search_state(const Graph &g, Args... queue_args)
+	: dist{g.width, g.height}, Q{queue_args...}
+	, neighbors{4 + g.n_lifts} {
+		reserve_vertices(Q, g.width, g.height);
+	}
+
+	search_state(const search_state &other) = delete;
+	search_state(search_state &&other) = delete;
+	search_state &operator=(const search_state &other) = delete;
+	search_state &operator=(search_state &&other) = delete;
+
+	Dist dist;
+	Queue Q;
+	fixed_vector<neighbor> neighbors;
+};
+
+// Relaxes every edge leaving u, which has been settled at dist_u, inserting
+// the vertices whose distance improved into the queue. Graphs which can do
+// better than going through compute_neighbors provide an overload (see
+// compact_graph.hpp), which is picked up by dijkstra() through ADL.
+template <typename Graph, typename Queue, typename Layout, typename Dist>
+void relax_edges(const Graph &g, vertex u, int dist_u, search_state<Queue, Layout, Dist> &state) {
+	g.compute_neighbors(dist_u, u, state.neighbors);
+	stats::relaxed(state.neighbors.size());
+
+	for (auto [v, edge] : state.neighbors) {
+		auto alt = dist_u + edge;
+
+		if (alt < state.dist[v]) {
+			state.dist.set(v, alt);
+			bool added = state.Q.insert(alt, v);
+			stats::inserted(added);
+		}
+	}
+}
+
+// Based on the description and pseudo-code from Wikipedia:
+// https://en.wikipedia.org/wiki/Dijkstra's_algorithm#Using_a_priority_queue
+// Implements the variant where only source is added to the queue, and
+// new elements are added in place of Q.decrease_priority. Outdated
+// entries are recognized by their priority and skipped. The indexed
+// pairing heap lowers the priority of a queued vertex instead, so it has
+// none.
+// Queue is any of the priority queues from heap.hpp. The state is
+// cleared before the search, so it can be reused between searches.
+// Graph is either a map, which computes the edges on the fly, or anything
+// else with the same layout, width, height, n_lifts, max_edge() and
+// compute_neighbors(), like compact_graph.
+// The search leaves the source at the given departure time, which only
+// changes the waits for lifts, and state.dist ends up holding arrival times
+// rather than distances. The bucket queue assumes a departure at 0.
+template <typename Queue, typename Graph, typename Dist>
+search_result dijkstra(const Graph &g, vertex source, vertex target,
+		search_state<Queue, typename Graph::layout, Dist> &state, int departure = 0) {
+	auto &dist = state.dist;
+	auto &Q = state.Q;
+	int settled = 0;
+
+	Q.clear();
+	dist.reset();
+	stats::queue_cleared();
+
+	Q.insert(departure, source);
+	dist.set(source, departure);
+	stats::pushed();
+
+	while (!Q.empty()) {
+		auto [priority, u] = Q.extract_min();
+		int dist_u = dist[u];
+		stats::popped(priority > dist_u);
+		if (priority > dist_u) continue;
+
+		settled++;
+		if (u == target) break;
+
+		relax_edges(g, u, dist_u, state);
+	}
+
+	return {dist[target] - departure, settled};
+}
+
+// Like dijkstra(), but without a target: settles every vertex reachable
+// from the source, leaving the distances in state.dist. Returns the number
+// of settled vertices.
+template <typename Queue, typename Graph, typename Dist>
+int dijkstra_all(const Graph &g, vertex source,
+		search_state<Queue, typename Graph::layout, Dist> &state) {
+	auto &dist = state.dist;
+	auto &Q = state.Q;
+	int settled = 0;
+
+	Q.clear();
+	dist.reset();
+	stats::queue_cleared();
+
+	Q.insert(0, source);
+	dist.set(source, 0);
+	stats::pushed();
+
+	while (!Q.empty()) {
+		auto [priority, u] = Q.extract_min();
+		int dist_u = dist[u];
+		stats::popped(priority > dist_u);
+		if (priority > dist_u) continue;
+
+		settled++;
+		relax_edges(g, u, dist_u, state);
+	}
+
+	return settled;
+}
+
+template <typename Queue = pairing_heap, typename Graph>
+search_result dijkstra(const Graph &g, vertex source, vertex target) {
+	search_state<Queue, typename Graph::layout> state{g};
+	return dijkstra(g, source, target, state);
+}
+
+// Above this many buckets, the bucket queue mostly scans empty buckets,
+// and takes up more memory than it's worth.
+constexpr int dial_max_buckets = 1 << 16;
+
+// Dial's algorithm: Dijkstra's algorithm with a bucket queue indexed by
+// distance. Falls back to the radix heap when the edge weights are too
+// large for the buckets to pay off.
+template <typename Graph>
+search_result dial(const Graph &g, vertex source, vertex target) {
+	int max_edge = g.max_edge();
+	if (max_edge >= dial_max_buckets)
+		return dijkstra<radix_heap>(g, source, target);
+
+	search_state<bucket_queue, typename Graph::layout> state{g, max_edge};
+	return dijkstra(g, source, target, state);
+}
+
+// Answers many queries on the same graph, keeping the search state around
+// between them.
+template <typename Queue, typename Graph = map>
+struct router {
+	template <typename... Args>
+	explicit router(const Graph &g, Args... queue_args)
+	: g_{g}, state_{g, queue_args...} { }
+
+	router(const router &other) = delete;
+	router(router &&other) = delete;
+	router &operator=(const router &other) = delete;
+	router &operator=(router &&other) = delete;
+
+	search_result route(vertex source, vertex target) {
+		return dijkstra(g_, source, target, state_);
+	}
+
+private:
+	const Graph &g_;
+	search_state<Queue, typename Graph::layout> state_;
+};
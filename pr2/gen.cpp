@@ -0,0 +1,124 @@
+#include <cstdio>  // fprintf
+#include <cstdlib> // atoi, strtoull
+#include <cstring> // strcmp
+
+#include "../common/fast_io.hpp"
+#include "generator.hpp"
+#include "map.hpp"
+#include "types.hpp"
+
+// Writes a synthetic map in the input format of pr2 to stdout, with the
+// query going between opposite corners. See generator.hpp for what the
+// options mean.
+//
+// Usage: pr2-gen WIDTH HEIGHT [--profile flat | random | sawtooth | ridges | slope]
+//	[--max-height N] [--period N] [--lifts N] [--hubs N] [--clustering PERCENT]
+//	[--max-period N] [--max-travel N] [--seed N]
+
+namespace {
+
+bool parse_profile(const char *name, height_profile &profile) {
+	struct {
+		const char *name;
+		height_profile profile;
+	} profiles[] = {
+		{"flat", height_profile::flat},
+		{"random", height_profile::random},
+		{"sawtooth", height_profile::sawtooth},
+		{"ridges", height_profile::ridges},
+		{"slope", height_profile::slope},
+	};
+
+	for (auto p : profiles) {
+		if (!strcmp(name, p.name)) {
+			profile = p.profile;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+} // namespace anonymous
+
+int main(int argc, char **argv) {
+	generator_options opts;
+	bool ok = argc >= 3;
+
+	if (ok) {
+		opts.width = atoi(argv[1]);
+		opts.height = atoi(argv[2]);
+		ok = opts.width > 0 && opts.height > 0;
+	}
+
+	for (int i = 3; ok && i < argc; i++) {
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!value) {
+			ok = false;
+			break;
+		}
+
+		if (!strcmp(argv[i], "--profile"))
+			ok = parse_profile(value, opts.profile);
+		else if (!strcmp(argv[i], "--max-height"))
+			opts.max_height = atoi(value);
+		else if (!strcmp(argv[i], "--period"))
+			opts.period = atoi(value);
+		else if (!strcmp(argv[i], "--lifts"))
+			opts.n_lifts = atoi(value);
+		else if (!strcmp(argv[i], "--hubs"))
+			opts.n_hubs = atoi(value);
+		else if (!strcmp(argv[i], "--clustering"))
+			opts.clustering = atoi(value);
+		else if (!strcmp(argv[i], "--max-period"))
+			opts.max_period = atoi(value);
+		else if (!strcmp(argv[i], "--max-travel"))
+			opts.max_travel = atoi(value);
+		else if (!strcmp(argv[i], "--seed"))
+			opts.seed = strtoull(value, nullptr, 10);
+		else
+			ok = false;
+
+		i++;
+	}
+
+	if (!ok || opts.max_height < 0 || opts.n_lifts < 0 || opts.n_hubs < 0) {
+		fprintf(stderr, "usage: %s WIDTH HEIGHT [--profile flat | random | sawtooth | ridges | slope]"
+				" [--max-height N] [--period N] [--lifts N] [--hubs N] [--clustering PERCENT]"
+				" [--max-period N] [--max-travel N] [--seed N]\n", argv[0]);
+		return 1;
+	}
+
+	map_generator gen{opts};
+	output_writer out;
+
+	auto header = gen.header();
+	int fields[] = {header.width, header.height, header.start.x, header.start.y,
+		header.end.x, header.end.y, header.n_lifts};
+
+	auto write_line = [&] (const int *values, int n) {
+		for (int i = 0; i < n; i++) {
+			if (i) out.write_char(' ');
+			out.write_int(values[i]);
+		}
+		out.write_char('\n');
+	};
+
+	write_line(fields, 7);
+
+	for (int i = 0; i < opts.n_lifts; i++) {
+		auto l = gen.next_lift();
+		int lift_fields[] = {l.from.x, l.from.y, l.to.x, l.to.y, l.travel_time, l.leaves_every};
+		write_line(lift_fields, 6);
+	}
+
+	for (int y = 0; y < opts.height; y++) {
+		for (int x = 0; x < opts.width; x++) {
+			if (x) out.write_char(' ');
+			out.write_int(gen.height_at(x, y));
+		}
+		out.write_char('\n');
+	}
+
+	return out.flush() ? 0 : 1;
+}
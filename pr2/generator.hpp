@@ -0,0 +1,158 @@
+#pragma once
+
+#include "map.hpp"
+#include "types.hpp"
+
+// Synthetic maps for benchmarks, deterministic for a given set of options.
+
+enum class height_profile {
+	// Every height the same, so every step costs 1.
+	flat,
+	// Independent random heights in [0, max_height].
+	random,
+	// Rising steadily along x over each period, then dropping back down,
+	// so every step right is uphill except one per period.
+	sawtooth,
+	// Diagonal ridges one period apart, with a little noise.
+	ridges,
+	// One slope rising towards the bottom right corner, with a little noise.
+	slope,
+};
+
+struct generator_options {
+	int width = 100, height = 100;
+	height_profile profile = height_profile::random;
+	int max_height = 100;
+	// Of the sawtooth and the ridges.
+	int period = 16;
+
+	int n_lifts = 0;
+	// Lifts start and end at one of n_hubs hub cells, except for a
+	// (100 - clustering)% share of them which connect random cells.
+	// Without hubs, every lift connects random cells.
+	int n_hubs = 0;
+	int clustering = 100;
+	// Lifts leave every 1 to max_period, and take 1 to max_travel.
+	int max_period = 1;
+	int max_travel = 50;
+
+	unsigned long long seed = 1;
+};
+
+struct map_generator {
+	explicit map_generator(const generator_options &opts)
+	: opts_{opts}, rng_{opts.seed}, hubs_{new vertex[opts.n_hubs > 0 ? opts.n_hubs : 1]} {
+		for (int i = 0; i < opts.n_hubs; i++)
+			hubs_[i] = random_vertex_();
+	}
+
+	map_generator(const map_generator &other) = delete;
+	map_generator(map_generator &&other) = delete;
+	map_generator &operator=(const map_generator &other) = delete;
+	map_generator &operator=(map_generator &&other) = delete;
+
+	~map_generator() {
+		delete[] hubs_;
+	}
+
+	// The query goes between opposite corners.
+	map_header header() const {
+		return {opts_.width, opts_.height, {0, 0},
+			{opts_.width - 1, opts_.height - 1}, opts_.n_lifts};
+	}
+
+	// Heights only depend on the position and the seed, so they can be
+	// generated in any order.
+	int height_at(int x, int y) const {
+		int max = opts_.max_height;
+		int period = opts_.period > 0 ? opts_.period : 1;
+		int noise = max / 10;
+
+		switch (opts_.profile) {
+			case height_profile::flat:
+				return 0;
+			case height_profile::random:
+				return hash_(x, y) % (max + 1);
+			case height_profile::sawtooth:
+				return static_cast<long long>(x % period) * max / period;
+			case height_profile::ridges: {
+				int phase = (x + y) % (2 * period);
+				int tri = phase < period ? phase : 2 * period - phase;
+				return static_cast<long long>(tri) * (max - noise) / period
+					+ hash_(x, y) % (noise + 1);
+			}
+			case height_profile::slope:
+				return static_cast<long long>(x + y) * (max - noise)
+					/ (opts_.width + opts_.height)
+					+ hash_(x, y) % (noise + 1);
+		}
+
+		return 0;
+	}
+
+	// Each call returns the next of the n_lifts lifts.
+	lift next_lift() {
+		auto endpoint = [&] {
+			if (opts_.n_hubs > 0 && static_cast<int>(rng_.next(100)) < opts_.clustering)
+				return hubs_[rng_.next(opts_.n_hubs)];
+			return random_vertex_();
+		};
+
+		lift l;
+		l.from = endpoint();
+		l.to = endpoint();
+		l.travel_time = 1 + rng_.next(opts_.max_travel > 0 ? opts_.max_travel : 1);
+		l.leaves_every = 1 + rng_.next(opts_.max_period > 0 ? opts_.max_period : 1);
+		return l;
+	}
+
+	// Builds the whole map.
+	map *generate() {
+		auto m = new map{opts_.width, opts_.height, opts_.n_lifts};
+
+		for (int i = 0; i < opts_.n_lifts; i++)
+			m->add_lift(next_lift());
+		m->index_lifts();
+
+		int *plane = new int[static_cast<long long>(opts_.width) * opts_.height];
+		for (int y = 0; y < opts_.height; y++) {
+			for (int x = 0; x < opts_.width; x++)
+				plane[x + static_cast<long long>(opts_.width) * y] = height_at(x, y);
+		}
+
+		m->load_heights(plane, 0);
+		delete[] plane;
+		return m;
+	}
+
+private:
+	// Same LCG as the benchmarks use for random queries.
+	struct lcg {
+		unsigned long long state;
+
+		unsigned int next(unsigned int bound) {
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			return static_cast<unsigned int>((state >> 33) % bound);
+		}
+	};
+
+	vertex random_vertex_() {
+		int x = rng_.next(opts_.width);
+		int y = rng_.next(opts_.height);
+		return {x, y};
+	}
+
+	// Non-negative hash of a position and the seed (splitmix64 finalizer).
+	int hash_(int x, int y) const {
+		unsigned long long h = opts_.seed
+			+ (static_cast<unsigned long long>(x) << 32 | static_cast<unsigned int>(y));
+		h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+		h ^= h >> 31;
+		return static_cast<int>(h & 0x7FFFFFFF);
+	}
+
+	const generator_options opts_;
+	lcg rng_;
+	vertex *const hubs_;
+};
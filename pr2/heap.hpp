@@ -0,0 +1,493 @@
+#pragma once
+
+#include "containers.hpp"
+#include "types.hpp"
+
+struct queue_entry {
+	int priority;
+	vertex vtx;
+};
+
+// All priority queues here share the same interface, so that dijkstra()
+// can take any of them as a template parameter:
+//
+//	bool insert(int priority, vertex vtx);
+//	queue_entry extract_min();
+//	bool empty() const;
+//	void clear(); // Keeps the allocated storage for reuse.
+//
+// insert() returns whether it added an entry, which only the indexed
+// pairing heap doesn't do, when it lowers the priority of a queued vertex
+// instead. The pairing and d-ary heaps can also peek at the minimum
+// priority:
+//
+//	int min_priority() const;
+
+// Based on the description and pseudo-code from Wikipedia:
+// https://en.wikipedia.org/wiki/Pairing_heap
+// Nodes live in one array and link to each other by their offset in it in
+// bytes, half the size of pointers, and unlike an index, turned into an
+// address by a single add. Extracted nodes are kept on a free list and
+// reused by later inserts, and clear() keeps the array for the next
+// search.
+//
+// With Indexed, every vertex also has a handle to its node, so inserting
+// a vertex that's already queued lowers its priority instead of adding
+// another node (and does nothing if the new priority isn't lower). The
+// handles are a table over the grid, which reserve_vertices() sizes up
+// front, and which otherwise grows as vertices come in. Keeping them, and
+// the links back that cutting a node out needs, makes every insert and
+// extract slower, which only pays off on maps where priorities actually
+// get lowered, so it's left to the callers to pick.
+template <bool Indexed>
+struct basic_pairing_heap {
+	basic_pairing_heap() = default;
+
+	basic_pairing_heap(const basic_pairing_heap &other) = delete;
+	basic_pairing_heap(basic_pairing_heap &&other) = delete;
+	basic_pairing_heap &operator=(const basic_pairing_heap &other) = delete;
+	basic_pairing_heap &operator=(basic_pairing_heap &&other) = delete;
+
+	~basic_pairing_heap() {
+		delete[] handles_;
+	}
+
+	void reserve_vertices(int width, int height) {
+		if (width > handles_width_ || height > handles_height_)
+			resize_handles_(width, height);
+	}
+
+	bool insert(int priority, vertex vtx) {
+		int h;
+
+		if constexpr (Indexed) {
+			int &handle = handle_(vtx);
+			if (queued_(handle, vtx)) {
+				if (priority < at_(handle).priority) decrease_(handle, priority);
+				return false;
+			}
+
+			h = handle = allocate_();
+		} else {
+			h = allocate_();
+		}
+
+		at_(h) = {priority, vtx, none, none, none};
+		root_ = meld_(root_, h);
+		return true;
+	}
+
+	queue_entry extract_min() {
+		auto &r = at_(root_);
+		queue_entry e{r.priority, r.vtx};
+
+		int child = r.child;
+		r.prev = extracted;
+		r.sibling = free_;
+		free_ = root_;
+		root_ = merge_pairs_(child);
+
+		return e;
+	}
+
+	int min_priority() const {
+		return at_(root_).priority;
+	}
+
+	bool empty() const {
+		return root_ == none;
+	}
+
+	void clear() {
+		if constexpr (Indexed) {
+			for (auto &n : nodes_)
+				handles_[index_(n.vtx)] = none;
+		}
+
+		nodes_.clear();
+		root_ = none;
+		free_ = none;
+	}
+
+private:
+	struct node {
+		int priority;
+		vertex vtx;
+
+		int child;
+		int sibling;
+		// Only kept with Indexed: the parent if this is the first child,
+		// the previous sibling otherwise, none for the root and extracted
+		// for nodes which have been taken out.
+		int prev;
+	};
+
+	static constexpr int none = -1;
+	static constexpr int extracted = -2;
+
+	node &at_(int offset) const {
+		return *reinterpret_cast<node *>(reinterpret_cast<char *>(nodes_.begin()) + offset);
+	}
+
+	// Offsets are ints, which leaves room for tens of millions of nodes
+	// at a time, far more than a queue over any grid that fits into
+	// memory holds.
+	int allocate_() {
+		int h;
+
+		if (free_ != none) {
+			h = free_;
+			free_ = at_(h).sibling;
+		} else {
+			h = nodes_.size() * static_cast<int>(sizeof(node));
+			nodes_.push({});
+		}
+
+		return h;
+	}
+
+	// Whether the handle of vtx points at its node, which is still in the
+	// heap. Handles are only reset by clear(), and extracted nodes get
+	// reused by other vertices in the meantime.
+	bool queued_(int h, vertex vtx) const {
+		if (h == none) return false;
+
+		auto &n = at_(h);
+		return n.vtx == vtx && n.prev != extracted;
+	}
+
+	int &handle_(vertex vtx) {
+		if (vtx.x >= handles_width_ || vtx.y >= handles_height_) {
+			int width = handles_width_, height = handles_height_;
+			if (vtx.x >= width) width = vtx.x + 1 > 2 * width ? vtx.x + 1 : 2 * width;
+			if (vtx.y >= height) height = vtx.y + 1 > 2 * height ? vtx.y + 1 : 2 * height;
+
+			resize_handles_(width, height);
+		}
+
+		return handles_[index_(vtx)];
+	}
+
+	long long index_(vertex vtx) const {
+		return vtx.x + static_cast<long long>(handles_width_) * vtx.y;
+	}
+
+	void resize_handles_(int width, int height) {
+		long long size = static_cast<long long>(width) * height;
+		int *handles = new int[size];
+		for (long long i = 0; i < size; i++) handles[i] = none;
+
+		for (int y = 0; y < handles_height_; y++) {
+			for (int x = 0; x < handles_width_; x++)
+				handles[x + static_cast<long long>(width) * y]
+					= handles_[x + static_cast<long long>(handles_width_) * y];
+		}
+
+		delete[] handles_;
+		handles_ = handles;
+		handles_width_ = width;
+		handles_height_ = height;
+	}
+
+	// Makes the root with the larger priority the first child of the
+	// other one. Both must have no siblings.
+	int meld_(int a, int b) {
+		if (a == none) return b;
+		else if (b == none) return a;
+
+		if (!(at_(a).priority < at_(b).priority)) {
+			int t = a;
+			a = b;
+			b = t;
+		}
+
+		auto &parent = at_(a), &child = at_(b);
+		child.sibling = parent.child;
+		if constexpr (Indexed) {
+			if (parent.child != none) at_(parent.child).prev = b;
+			child.prev = a;
+		}
+		parent.child = b;
+
+		return a;
+	}
+
+	// Cuts the subtree at n out of the heap, and melds it back with its
+	// new priority at the root.
+	void decrease_(int n, int priority) {
+		auto &at = at_(n);
+		at.priority = priority;
+		if (n == root_) return;
+
+		auto &prev = at_(at.prev);
+		if (prev.child == n) prev.child = at.sibling;
+		else prev.sibling = at.sibling;
+		if (at.sibling != none) at_(at.sibling).prev = at.prev;
+
+		at.sibling = none;
+		at.prev = none;
+		root_ = meld_(root_, n);
+	}
+
+	// The two pass merge, without recursion, since the list of children
+	// of the root can get very long: first meld the children in pairs
+	// from left to right, chaining the pairs in reverse through their
+	// siblings, then meld the pairs from right to left.
+	int merge_pairs_(int list) {
+		int pairs = none;
+
+		while (list != none) {
+			int a = list, b = at_(a).sibling;
+			list = b != none ? at_(b).sibling : none;
+
+			at_(a).sibling = none;
+			if (b != none) at_(b).sibling = none;
+
+			int melded = meld_(a, b);
+			at_(melded).sibling = pairs;
+			pairs = melded;
+		}
+
+		int root = none;
+
+		while (pairs != none) {
+			int next = at_(pairs).sibling;
+			at_(pairs).sibling = none;
+			root = meld_(pairs, root);
+			pairs = next;
+		}
+
+		if constexpr (Indexed) {
+			if (root != none) at_(root).prev = none;
+		}
+		return root;
+	}
+
+	dynamic_vector<node> nodes_;
+	int root_ = none;
+	// Linked through sibling.
+	int free_ = none;
+
+	int *handles_ = nullptr;
+	int handles_width_ = 0, handles_height_ = 0;
+};
+
+using pairing_heap = basic_pairing_heap<false>;
+using indexed_pairing_heap = basic_pairing_heap<true>;
+
+// search_state passes the size of the graph to the queue through this, and
+// queues which want it provide an overload, picked up through ADL.
+template <typename Queue>
+void reserve_vertices(Queue &, int, int) { }
+
+inline void reserve_vertices(indexed_pairing_heap &Q, int width, int height) {
+	Q.reserve_vertices(width, height);
+}
+
+// Implicit D-ary min-heap stored in a flat array, the children of
+// entry i are at D * i + 1 ... D * i + D.
+template <int D>
+struct dary_heap {
+	static_assert(D >= 2, "a heap needs at least two children per node");
+
+	dary_heap() = default;
+
+	dary_heap(const dary_heap &other) = delete;
+	dary_heap(dary_heap &&other) = delete;
+	dary_heap &operator=(const dary_heap &other) = delete;
+	dary_heap &operator=(dary_heap &&other) = delete;
+
+	bool insert(int priority, vertex vtx) {
+		entries_.push({priority, vtx});
+		sift_up_(entries_.size() - 1);
+		return true;
+	}
+
+	queue_entry extract_min() {
+		queue_entry e = entries_[0];
+
+		auto last = entries_.pop();
+		if (!entries_.empty()) {
+			entries_[0] = last;
+			sift_down_(0);
+		}
+
+		return e;
+	}
+
+	int min_priority() const {
+		return entries_[0].priority;
+	}
+
+	bool empty() const {
+		return entries_.empty();
+	}
+
+	void clear() {
+		entries_.clear();
+	}
+
+private:
+	void sift_up_(int i) {
+		queue_entry e = entries_[i];
+
+		while (i) {
+			int parent = (i - 1) / D;
+			if (entries_[parent].priority <= e.priority) break;
+
+			entries_[i] = entries_[parent];
+			i = parent;
+		}
+
+		entries_[i] = e;
+	}
+
+	void sift_down_(int i) {
+		queue_entry e = entries_[i];
+		int size = entries_.size();
+
+		while (true) {
+			int first = D * i + 1;
+			if (first >= size) break;
+
+			int last = first + D < size ? first + D : size;
+			int min = first;
+			for (int c = first + 1; c < last; c++) {
+				if (entries_[c].priority < entries_[min].priority)
+					min = c;
+			}
+
+			if (e.priority <= entries_[min].priority) break;
+
+			entries_[i] = entries_[min];
+			i = min;
+		}
+
+		entries_[i] = e;
+	}
+
+	dynamic_vector<queue_entry> entries_;
+};
+
+// Monotone radix heap, see:
+// Ahuja, Mehlhorn, Orlin, Tarjan - Faster Algorithms for the Shortest Path Problem (1990)
+// Only valid as long as no priority smaller than the last extracted one is
+// inserted, which holds for Dijkstra's algorithm with non-negative weights.
+// Entry with priority p lives in the bucket indexed by the position of the
+// highest bit in which p differs from the last extracted priority.
+struct radix_heap {
+	radix_heap() = default;
+
+	radix_heap(const radix_heap &other) = delete;
+	radix_heap(radix_heap &&other) = delete;
+	radix_heap &operator=(const radix_heap &other) = delete;
+	radix_heap &operator=(radix_heap &&other) = delete;
+
+	bool insert(int priority, vertex vtx) {
+		buckets_[bucket_for_(priority)].push({priority, vtx});
+		size_++;
+		return true;
+	}
+
+	queue_entry extract_min() {
+		if (buckets_[0].empty()) {
+			int i = 1;
+			while (buckets_[i].empty()) i++;
+
+			int min = buckets_[i][0].priority;
+			for (auto e : buckets_[i]) {
+				if (e.priority < min) min = e.priority;
+			}
+
+			last_ = min;
+			for (auto e : buckets_[i])
+				buckets_[bucket_for_(e.priority)].push(e);
+			buckets_[i].clear();
+		}
+
+		size_--;
+		return buckets_[0].pop();
+	}
+
+	bool empty() const {
+		return !size_;
+	}
+
+	void clear() {
+		for (auto &bucket : buckets_)
+			bucket.clear();
+
+		last_ = 0;
+		size_ = 0;
+	}
+
+private:
+	int bucket_for_(int priority) const {
+		unsigned int diff = static_cast<unsigned int>(priority ^ last_);
+		return diff ? 32 - __builtin_clz(diff) : 0;
+	}
+
+	static constexpr int n_buckets = 33;
+
+	dynamic_vector<queue_entry> buckets_[n_buckets];
+	int last_ = 0;
+	int size_ = 0;
+};
+
+// Circular bucket queue for Dial's algorithm, see:
+// Dial - Algorithm 360: Shortest-path forest with topological ordering (1969)
+// All priorities in the queue must lie within [m, m + max_delta], where m
+// is the last extracted priority, which holds for Dijkstra's algorithm as
+// long as max_delta bounds the edge weights. Unlike the other queues, this
+// one needs that bound up front, so it can't be default constructed.
+// Priorities are assumed to start at 0.
+struct bucket_queue {
+	explicit bucket_queue(int max_delta)
+	: n_buckets_{max_delta + 1}
+	, buckets_{new dynamic_vector<vertex>[max_delta + 1]} { }
+
+	bucket_queue(const bucket_queue &other) = delete;
+	bucket_queue(bucket_queue &&other) = delete;
+	bucket_queue &operator=(const bucket_queue &other) = delete;
+	bucket_queue &operator=(bucket_queue &&other) = delete;
+
+	~bucket_queue() {
+		delete[] buckets_;
+	}
+
+	bool insert(int priority, vertex vtx) {
+		buckets_[priority % n_buckets_].push(vtx);
+		size_++;
+		return true;
+	}
+
+	queue_entry extract_min() {
+		while (buckets_[cursor_].empty()) {
+			cursor_ = cursor_ + 1 == n_buckets_ ? 0 : cursor_ + 1;
+			current_++;
+		}
+
+		size_--;
+		return {current_, buckets_[cursor_].pop()};
+	}
+
+	bool empty() const {
+		return !size_;
+	}
+
+	void clear() {
+		for (int i = 0; i < n_buckets_; i++)
+			buckets_[i].clear();
+
+		cursor_ = 0;
+		current_ = 0;
+		size_ = 0;
+	}
+
+private:
+	const int n_buckets_;
+	dynamic_vector<vertex> *const buckets_;
+	int cursor_ = 0;
+	int current_ = 0;
+	int size_ = 0;
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <climits>
+
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "types.hpp"
+
+// Answers queries on a map that is edited between them, repairing the
+// result of the last search rather than searching again from scratch, with
+// Lifelong Planning A* without a heuristic, see:
+// Koenig, Likhachev, Furcy - Lifelong Planning A* (2004)
+//
+// Besides its arrival time g from the last search, every vertex has rhs,
+// the soonest it can be reached over a single edge from the g of another
+// vertex. Vertices where the two differ are inconsistent, and wait in the
+// queue by the smaller of the two. An edit changes rhs of just the heads of
+// the edited edges, and the repair then only visits vertices whose arrival
+// time actually changes, in order of arrival, until the target is
+// consistent and nothing left in the queue could still change it.
+//
+// Lift edges cost more or less depending on the arrival time, but arriving
+// somewhere later never means leaving it sooner, so ordering by arrival
+// time works just as it does for dijkstra().
+struct incremental_router {
+	explicit incremental_router(map &m)
+	: m_{m}, g_{m.width, m.height}, rhs_{m.width, m.height} { }
+
+	incremental_router(const incremental_router &other) = delete;
+	incremental_router(incremental_router &&other) = delete;
+	incremental_router &operator=(const incremental_router &other) = delete;
+	incremental_router &operator=(incremental_router &&other) = delete;
+
+	// Starts over if the source or the departure differ from the last
+	// query, otherwise continues from where the last search, and the edits
+	// since, left off. Settled counts the vertices taken off the queue.
+	search_result route(vertex source, vertex target, int departure = 0) {
+		if (!searched_ || !(source == source_) || departure != departure_) {
+			Q_.clear();
+			g_.reset();
+			rhs_.reset();
+
+			source_ = source;
+			departure_ = departure;
+			searched_ = true;
+
+			rhs_.set(source, departure);
+			Q_.insert(departure, source);
+		}
+
+		int settled = 0;
+
+		while (!Q_.empty()) {
+			// Lifts can take no time at all, so a vertex queued at the
+			// target's own key can still change it.
+			if (Q_.min_priority() > key_(target) && g_[target] == rhs_[target])
+				break;
+
+			auto [priority, u] = Q_.extract_min();
+			int g_u = g_[u], rhs_u = rhs_[u];
+			if (g_u == rhs_u || priority != key_(u)) continue;
+
+			settled++;
+
+			if (g_u > rhs_u) {
+				// Reached sooner than before.
+				g_.set(u, rhs_u);
+				for_each_edge_from_(u, rhs_u, [&] (vertex v, int arrival) {
+					if (v == source_ || arrival >= rhs_[v]) return;
+
+					rhs_.set(v, arrival);
+					queue_if_inconsistent_(v);
+				});
+			} else {
+				raise_(u);
+			}
+		}
+
+		int g_t = g_[target];
+		return {g_t == INT_MAX ? INT_MAX : g_t - departure_, settled};
+	}
+
+	// Edits the map, like the map functions of the same name. Edges that
+	// get slower and were on the way somewhere are dealt with before the
+	// edit, and edges that get faster after.
+	void set_height(vertex v, int h) {
+		if (!searched_) {
+			m_.set_height(v, h);
+			return;
+		}
+
+		int old = m_.heights[v];
+		auto slower = [&] (vertex from, vertex to, int new_to, int new_from) {
+			int A = new_to, B = new_from;
+			return (A > B ? A - B + 1 : 1) > grid_edge_(from, to)
+				&& on_the_way_(from, to, g_[from] + grid_edge_(from, to));
+		};
+
+		// Both the edges into and out of v change.
+		for_each_neighbor_(v, [&] (vertex u) {
+			if (slower(u, v, h, m_.heights[u])) raise_(v);
+			if (slower(v, u, m_.heights[u], h)) raise_(u);
+		});
+
+		m_.set_height(v, h);
+		if (h == old) return;
+
+		update_(v);
+		for_each_neighbor_(v, [&] (vertex u) { update_(u); });
+	}
+
+	void insert_lift(const lift &l) {
+		m_.insert_lift(l);
+		if (searched_) update_(l.to);
+	}
+
+	bool remove_lift(const lift &l) {
+		if (searched_) {
+			int g_from = g_[l.from];
+			if (on_the_way_(l.from, l.to, g_from + l.wait(g_from) + l.travel_time))
+				raise_(l.to);
+		}
+
+		// l may be one of the map's own lifts, which removing it moves.
+		vertex to = l.to;
+		if (!m_.remove_lift(l)) return false;
+
+		if (searched_) update_(to);
+		return true;
+	}
+
+	long long memory_bytes() const {
+		return 2LL * m_.width * m_.height * 2 * sizeof(int);
+	}
+
+private:
+	int key_(vertex v) const {
+		int g = g_[v], rhs = rhs_[v];
+		return g < rhs ? g : rhs;
+	}
+
+	// Whether an edge from -> to, arriving at the given time when leaving
+	// at g of from, may be how to is reached: either by g from the last
+	// search, or by rhs, when to has been reached sooner since and not
+	// been repaired yet.
+	bool on_the_way_(vertex from, vertex to, int arrival) const {
+		return g_[from] != INT_MAX && (arrival == g_[to] || arrival == rhs_[to]);
+	}
+
+	void queue_if_inconsistent_(vertex v) {
+		int g = g_[v], rhs = rhs_[v];
+		if (g != rhs) Q_.insert(g < rhs ? g : rhs, v);
+	}
+
+	template <typename F>
+	void for_each_neighbor_(vertex v, F f) const {
+		if (v.x > 0) f({v.x - 1, v.y});
+		if (v.x + 1 < m_.width) f({v.x + 1, v.y});
+		if (v.y > 0) f({v.x, v.y - 1});
+		if (v.y + 1 < m_.height) f({v.x, v.y + 1});
+	}
+
+	int grid_edge_(vertex from, vertex to) const {
+		int A = m_.heights[to], B = m_.heights[from];
+		return A > B ? A - B + 1 : 1;
+	}
+
+	// Calls f(v, arrival) for every edge u -> v, leaving u at time.
+	template <typename F>
+	void for_each_edge_from_(vertex u, int time, F f) const {
+		for_each_neighbor_(u, [&] (vertex v) { f(v, time + grid_edge_(u, v)); });
+
+		for (auto &l : m_.lifts_from(u))
+			f(l.to, time + l.wait(time) + l.travel_time);
+	}
+
+	// Forgets the arrival time of v and of everything that may have been
+	// reached by way of it, following the edges that arrive exactly at the
+	// arrival time of their head. With edges that take no time, rhs alone
+	// can't tell that a vertex lost its only way there, since it can be
+	// propped up by a neighbor at the same time that was itself only
+	// reached through it.
+	void raise_(vertex v) {
+		if (v == source_ || g_[v] == INT_MAX) return;
+
+		raised_.clear();
+		raised_.push({g_[v], v});
+		g_.set(v, INT_MAX);
+
+		for (int i = 0; i < raised_.size(); i++) {
+			auto [g_u, u] = raised_[i];
+
+			for_each_edge_from_(u, g_u, [&] (vertex w, int arrival) {
+				if (w == source_ || arrival != g_[w]) return;
+
+				raised_.push({arrival, w});
+				g_.set(w, INT_MAX);
+			});
+		}
+
+		// Then look for other ways to everything raised, and everything
+		// which may have been reached from it.
+		for (auto [g_u, u] : raised_) {
+			update_(u);
+			for_each_edge_from_(u, g_u, [&] (vertex w, int arrival) {
+				if (arrival == rhs_[w]) update_(w);
+			});
+		}
+	}
+
+	// Recomputes rhs of v from the edges into it.
+	void update_(vertex v) {
+		if (!(v == source_)) {
+			int best = INT_MAX;
+
+			for_each_neighbor_(v, [&] (vertex u) {
+				int g_u = g_[u];
+				if (g_u == INT_MAX) return;
+
+				int arrival = g_u + grid_edge_(u, v);
+				if (arrival < best) best = arrival;
+			});
+
+			// A lift back to where it left from can't ever arrive any
+			// sooner, but could keep a stale rhs up.
+			for (auto &l : m_.lifts_to(v)) {
+				if (l.from == v) continue;
+
+				int g_u = g_[l.from];
+				if (g_u == INT_MAX) continue;
+
+				int arrival = g_u + l.wait(g_u) + l.travel_time;
+				if (arrival < best) best = arrival;
+			}
+
+			rhs_.set(v, best);
+		}
+
+		queue_if_inconsistent_(v);
+	}
+
+	map &m_;
+	distance_table<> g_;
+	distance_table<> rhs_;
+	dary_heap<4> Q_;
+	// Each with the arrival time it had before.
+	dynamic_vector<queue_entry> raised_;
+
+	bool searched_ = false;
+	vertex source_;
+	int departure_ = 0;
+};
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <cstdio>     // fprintf
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+#include "../common/fast_io.hpp"
+#include "astar.hpp"
+#include "containers.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "types.hpp"
+
+// The map with the waits for lifts dropped, so that every lift edge costs
+// just its travel time. Edges here never cost more than the same edges in
+// the map, whatever the departure time, so distances here are lower bounds
+// on distances in the map.
+struct lower_bound_graph {
+	using layout = map::layout;
+
+	explicit lower_bound_graph(const map &m)
+	: width{m.width}, height{m.height}, n_lifts{m.n_lifts}, m_{m} { }
+
+	int max_edge() const {
+		return m_.max_edge();
+	}
+
+	// Every lift departs at time 0.
+	void compute_neighbors(int, vertex from, fixed_vector<neighbor> &out) const {
+		m_.compute_neighbors(0, from, out);
+	}
+
+	const int width, height;
+	const int n_lifts;
+
+private:
+	const map &m_;
+};
+
+// Same as lower_bound_graph, but with every edge reversed, so searching it
+// from v finds the distances to v.
+struct reversed_lower_bound_graph {
+	using layout = map::layout;
+
+	explicit reversed_lower_bound_graph(const map &m)
+	: width{m.width}, height{m.height}, n_lifts{m.n_lifts}, m_{m} { }
+
+	int max_edge() const {
+		return m_.max_edge();
+	}
+
+	void compute_neighbors(int, vertex to, fixed_vector<neighbor> &out) const {
+		m_.compute_reverse_neighbors(to, out);
+	}
+
+	const int width, height;
+	const int n_lifts;
+
+private:
+	const map &m_;
+};
+
+// Hash of the heights and lifts, so that landmarks aren't used with a map
+// other than the one they were computed for (FNV-1a).
+inline unsigned long long map_fingerprint(const map &m) {
+	unsigned long long hash = 0xCBF29CE484222325ULL;
+
+	auto mix = [&] (const void *data, long long size) {
+		auto bytes = static_cast<const unsigned char *>(data);
+		for (long long i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ULL;
+		}
+	};
+
+	mix(&m.width, sizeof(m.width));
+	mix(&m.height, sizeof(m.height));
+	mix(m.heights.data, static_cast<long long>(m.heights.size) * sizeof(int));
+
+	auto lifts = m.all_lifts();
+	mix(lifts.begin(), static_cast<long long>(lifts.size()) * sizeof(lift));
+
+	return hash;
+}
+
+// Distances from and to a handful of landmark vertices in the
+// lower_bound_graph, for goal-directed search with ALT (A*, landmarks and
+// the triangle inequality). For any landmark L, the distance from v to t
+// is at least d(L, t) - d(L, v), and at least d(v, L) - d(t, L).
+//
+// The tables are stored with the distances of all landmarks for a vertex
+// next to each other, so a heuristic lookup touches one or two cache lines
+// per vertex.
+struct landmarks {
+	// Picks count landmarks spread over the map and computes their tables,
+	// with two full searches per landmark. The first landmark is the
+	// vertex farthest from the top left corner, each next one is the one
+	// farthest from all landmarks so far.
+	landmarks(const map &m, int n_landmarks)
+	: width{m.width}, height{m.height}
+	, count{n_landmarks < m.width * m.height ? n_landmarks : m.width * m.height}
+	, fingerprint{map_fingerprint(m)} {
+		int cells = width * height;
+		auto vertices = new vertex[count];
+		auto from = new int[static_cast<long long>(cells) * count];
+		auto to = new int[static_cast<long long>(cells) * count];
+		vertices_ = vertices;
+		from_ = from;
+		to_ = to;
+
+		lower_bound_graph forward{m};
+		reversed_lower_bound_graph backward{m};
+		search_state<radix_heap> state{forward};
+
+		// Smallest distance from any landmark so far.
+		int *closest = new int[cells];
+
+		auto farthest = [&] {
+			int best = 0;
+			for (int i = 1; i < cells; i++)
+				if (closest[i] > closest[best]) best = i;
+			return vertex{best % width, best / width};
+		};
+
+		dijkstra_all(forward, {0, 0}, state);
+		for (int i = 0; i < cells; i++)
+			closest[i] = state.dist[{i % width, i / width}];
+		vertex next = farthest();
+
+		for (int i = 0; i < cells; i++) closest[i] = INT_MAX;
+
+		for (int l = 0; l < count; l++) {
+			vertices[l] = next;
+
+			dijkstra_all(forward, next, state);
+			for (int i = 0; i < cells; i++) {
+				int d = state.dist[{i % width, i / width}];
+				from[static_cast<long long>(i) * count + l] = d;
+				if (d < closest[i]) closest[i] = d;
+			}
+
+			dijkstra_all(backward, next, state);
+			for (int i = 0; i < cells; i++)
+				to[static_cast<long long>(i) * count + l] = state.dist[{i % width, i / width}];
+
+			next = farthest();
+		}
+
+		delete[] closest;
+	}
+
+	landmarks(const landmarks &other) = delete;
+	landmarks(landmarks &&other) = delete;
+	landmarks &operator=(const landmarks &other) = delete;
+	landmarks &operator=(landmarks &&other) = delete;
+
+	~landmarks() {
+		if (mapping_) {
+			munmap(mapping_, mapping_size_);
+		} else {
+			delete[] from_;
+			delete[] to_;
+			delete[] vertices_;
+		}
+	}
+
+	// Distances from each landmark to v.
+	const int *from(vertex v) const {
+		return from_ + static_cast<long long>(v.x + width * v.y) * count;
+	}
+
+	// Distances from v to each landmark.
+	const int *to(vertex v) const {
+		return to_ + static_cast<long long>(v.x + width * v.y) * count;
+	}
+
+	vertex landmark(int i) const {
+		return vertices_[i];
+	}
+
+	long long memory_bytes() const {
+		return 2LL * width * height * count * sizeof(int);
+	}
+
+	const int width, height;
+	const int count;
+	const unsigned long long fingerprint;
+
+private:
+	friend struct landmark_file;
+
+	// Used by landmark_file, with the tables pointing into the mapped file.
+	landmarks(int width, int height, int count, unsigned long long fingerprint,
+			void *mapping, long long mapping_size,
+			const vertex *vertices, const int *from, const int *to)
+	: width{width}, height{height}, count{count}, fingerprint{fingerprint}
+	, vertices_{vertices}, from_{from}, to_{to}
+	, mapping_{mapping}, mapping_size_{mapping_size} { }
+
+	const vertex *vertices_ = nullptr;
+	const int *from_ = nullptr;
+	const int *to_ = nullptr;
+
+	// Set if the tables come from a mapped file rather than the heap.
+	void *mapping_ = nullptr;
+	long long mapping_size_ = 0;
+};
+
+// Lower bound on the distance to the target from the landmark tables. Every
+// vertex of the grid can reach every other one, so none of the distances
+// in the tables are INT_MAX. The maximum of consistent heuristics is
+// consistent, so this can be used with astar().
+struct alt_heuristic {
+	alt_heuristic(const landmarks &l, vertex target)
+	: l_{l}, from_target_{l.from(target)}, to_target_{l.to(target)} { }
+
+	int operator()(vertex v) const {
+		const int *from_v = l_.from(v), *to_v = l_.to(v);
+		int best = 0;
+
+		for (int i = 0; i < l_.count; i++) {
+			int ahead = from_target_[i] - from_v[i];
+			int behind = to_v[i] - to_target_[i];
+			if (ahead > best) best = ahead;
+			if (behind > best) best = behind;
+		}
+
+		return best;
+	}
+
+private:
+	const landmarks &l_;
+	const int *from_target_, *to_target_;
+};
+
+// Answers many queries with ALT on the same map, keeping the search state
+// around between them, like router does for dijkstra().
+template <typename Queue = dary_heap<4>>
+struct alt_router {
+	alt_router(const map &m, const landmarks &l)
+	: m_{m}, l_{l}, state_{m} { }
+
+	alt_router(const alt_router &other) = delete;
+	alt_router(alt_router &&other) = delete;
+	alt_router &operator=(const alt_router &other) = delete;
+	alt_router &operator=(alt_router &&other) = delete;
+
+	search_result route(vertex source, vertex target) {
+		return astar(m_, source, target, alt_heuristic{l_, target}, state_);
+	}
+
+private:
+	const map &m_;
+	const landmarks &l_;
+	search_state<Queue> state_;
+};
+
+// Binary format for the landmark tables, to be kept next to the map they
+// were computed for. Like map_file, all fields are in the native byte order.
+//
+//	header
+//	landmarks: count vertex structs
+//	from:      width * height * count ints, row-major by vertex, then by
+//	           landmark
+//	to:        same as from
+struct landmark_file {
+	static constexpr char magic[8] = {'P', 'R', '2', 'L', 'M', 'K', '\r', '\n'};
+	static constexpr unsigned int version = 1;
+	static constexpr unsigned int byte_order = 0x01020304;
+
+	struct header {
+		char magic[8];
+		unsigned int version;
+		unsigned int byte_order;
+
+		int width, height;
+		int count;
+		unsigned int reserved0;
+		unsigned long long fingerprint;
+		unsigned int reserved[6];
+	};
+
+	static_assert(sizeof(header) == 64, "the header layout is part of the format");
+
+	static long long table_size(const header &h) {
+		return static_cast<long long>(h.width) * h.height * h.count * sizeof(int);
+	}
+
+	static long long file_size(const header &h) {
+		return sizeof(header) + h.count * sizeof(vertex) + 2 * table_size(h);
+	}
+
+	// Checks that the header matches the file size and the map the
+	// tables are meant for, returning what's wrong, or nullptr if nothing.
+	static const char *validate(const header &h, long long size, const map &m) {
+		for (int i = 0; i < 8; i++)
+			if (h.magic[i] != magic[i]) return "not a landmark file";
+
+		if (h.byte_order != byte_order) return "written on a machine with a different byte order";
+		if (h.version != version) return "unsupported version";
+		if (h.width != m.width || h.height != m.height) return "computed for a map of a different size";
+		if (h.count < 1 || h.count > m.width * m.height) return "invalid landmark count";
+		if (size != file_size(h)) return "file size doesn't match the header";
+		if (h.fingerprint != map_fingerprint(m)) return "computed for a different map";
+
+		return nullptr;
+	}
+
+	// Prints what went wrong and returns false on failure.
+	static bool save(const landmarks &l, const char *path) {
+		int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "%s: failed to open for writing\n", path);
+			return false;
+		}
+
+		header h{};
+		for (int i = 0; i < 8; i++) h.magic[i] = magic[i];
+		h.version = version;
+		h.byte_order = byte_order;
+		h.width = l.width;
+		h.height = l.height;
+		h.count = l.count;
+		h.fingerprint = l.fingerprint;
+
+		output_writer out{fd};
+		out.write_bytes(&h, sizeof(h));
+		out.write_bytes(l.vertices_, l.count * sizeof(vertex));
+		out.write_bytes(l.from_, table_size(h));
+		out.write_bytes(l.to_, table_size(h));
+
+		bool ok = out.flush();
+		if (close(fd) < 0) ok = false;
+
+		if (!ok) fprintf(stderr, "%s: failed to write\n", path);
+		return ok;
+	}
+
+	// Loads tables written by save(), checking that they were computed
+	// for the given map. The tables are used straight from the mapped
+	// file. Prints what went wrong and returns nullptr on failure.
+	static landmarks *load(const char *path, const map &m) {
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "%s: failed to open\n", path);
+			return nullptr;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) < 0 || st.st_size < static_cast<long long>(sizeof(header))) {
+			fprintf(stderr, "%s: file too small for the header\n", path);
+			close(fd);
+			return nullptr;
+		}
+
+		void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED) {
+			fprintf(stderr, "%s: failed to map\n", path);
+			return nullptr;
+		}
+
+		auto base = static_cast<const char *>(data);
+		auto &h = *reinterpret_cast<const header *>(base);
+
+		if (auto error = validate(h, st.st_size, m)) {
+			fprintf(stderr, "%s: %s\n", path, error);
+			munmap(data, st.st_size);
+			return nullptr;
+		}
+
+		auto vertices = reinterpret_cast<const vertex *>(base + sizeof(header));
+		auto from = reinterpret_cast<const int *>(base + sizeof(header) + h.count * sizeof(vertex));
+		auto to = reinterpret_cast<const int *>(reinterpret_cast<const char *>(from) + table_size(h));
+
+		return new landmarks{h.width, h.height, h.count, h.fingerprint,
+				data, st.st_size, vertices, from, to};
+	}
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "types.hpp"
+
+// Layout policies for array2d, mapping a vertex to its index in the
+// underlying array. Each one is constructed from the size of the grid,
+// and reports how many elements the array needs, which may be more than
+// width * height if the layout needs padding.
+
+// The usual x + width * y.
+struct row_major {
+	row_major(int width, int)
+	: width_{width} { }
+
+	int size(int, int height) const {
+		return width_ * height;
+	}
+
+	int operator()(vertex v) const {
+		return v.x + width_ * v.y;
+	}
+
+private:
+	int width_;
+};
+
+// The grid is split into Size x Size tiles, which are stored one after
+// another in row-major order, with the cells of each tile also in
+// row-major order. Vertical neighbors are then usually Size cells apart,
+// rather than a whole row. Size must be a power of two.
+template <int Size>
+struct tiled {
+	static_assert(Size > 0 && !(Size & (Size - 1)), "tile size must be a power of two");
+
+	tiled(int width, int)
+	: tiles_per_row_{(width + Size - 1) / Size} { }
+
+	int size(int, int height) const {
+		return tiles_per_row_ * ((height + Size - 1) / Size) * Size * Size;
+	}
+
+	int operator()(vertex v) const {
+		int tile = v.x / Size + tiles_per_row_ * (v.y / Size);
+		return tile * Size * Size + v.x % Size + Size * (v.y % Size);
+	}
+
+private:
+	int tiles_per_row_;
+};
+
+// Z-order curve: the bits of x and y are interleaved, so that cells close
+// to each other in both directions tend to be close in memory. Each
+// dimension is padded to a power of two, and once the smaller one runs out
+// of bits, the remaining bits of the larger one are put on top, so thin
+// maps don't get padded to a square.
+struct morton {
+	morton(int width, int height)
+	: x_bits_{bits_for_(width)}, y_bits_{bits_for_(height)}
+	, shared_bits_{x_bits_ < y_bits_ ? x_bits_ : y_bits_}
+	, shared_mask_{(1 << shared_bits_) - 1} { }
+
+	int size(int, int) const {
+		return 1 << (x_bits_ + y_bits_);
+	}
+
+	int operator()(vertex v) const {
+		int low = spread_(v.x & shared_mask_) | (spread_(v.y & shared_mask_) << 1);
+		// Only one of these is ever non-zero.
+		int high = (v.x >> shared_bits_) | (v.y >> shared_bits_);
+		return low | (high << (2 * shared_bits_));
+	}
+
+private:
+	static int bits_for_(int n) {
+		int bits = 0;
+		while ((1 << bits) < n) bits++;
+		return bits;
+	}
+
+	// Moves bit i of the lower 16 bits to bit 2 * i.
+	static int spread_(int v) {
+		unsigned int u = v;
+		u = (u | (u << 8)) & 0x00FF00FF;
+		u = (u | (u << 4)) & 0x0F0F0F0F;
+		u = (u | (u << 2)) & 0x33333333;
+		u = (u | (u << 1)) & 0x55555555;
+		return u;
+	}
+
+	int x_bits_, y_bits_;
+	int shared_bits_, shared_mask_;
+};
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <climits>
+#include <cstdlib> // malloc, realloc, free
+
+#include "../common/fast_io.hpp"
+#include "containers.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "types.hpp"
+
+// A map for inputs too big for map, which spends 8 bytes per cell before
+// any search: the heights as ints and the offsets of the lift index. Here
+// the heights take 1, 2 or 4 bytes per cell, whichever fits their range,
+// and the lifts are found by binary search over just the cells that have
+// any. Searches store distances in 2 bytes per cell where the answer is
+// known to fit, and in 4 otherwise, without the epochs of distance_table.
+// On a map with heights within 255 of each other, that's 3 bytes per cell
+// in all, so a 20000x20000 map takes about 1.2 GB.
+
+// Heights read from text straight into as few bytes per cell as their
+// range needs, without ever holding them all as ints. While reading, each
+// is stored offset from the first one, in 1 byte until one doesn't fit,
+// then 2, then 4, widening what's been read so far in place. Once all are
+// read, they are stored again offset from the lowest one, which may take
+// fewer bytes than were needed while reading.
+struct narrow_heights {
+	narrow_heights(int width, int height)
+	: width{width}, height{height} { }
+
+	narrow_heights(const narrow_heights &other) = delete;
+	narrow_heights(narrow_heights &&other) = delete;
+	narrow_heights &operator=(const narrow_heights &other) = delete;
+	narrow_heights &operator=(narrow_heights &&other) = delete;
+
+	~narrow_heights() {
+		free(data_);
+	}
+
+	// Reads the width * height heights in row-major order, returns false
+	// if the input ended early or there's not enough memory.
+	bool read(input_reader &in) {
+		long long cells = static_cast<long long>(width) * height;
+		bytes = 1;
+		data_ = static_cast<unsigned char *>(malloc(cells));
+		if (!data_) return false;
+
+		int first;
+		if (!in.read_int(first)) return false;
+		base_ = first;
+		bias_ = 0x80;
+		min_height = max_height = first;
+
+		for (long long i = 0; i < cells; i++) {
+			int h = first;
+			if (i && !in.read_int(h)) return false;
+
+			long long stored = static_cast<long long>(h) - base_ + bias_;
+			while (stored < 0 || stored > largest_(bytes)) {
+				if (!widen_(i)) return false;
+				stored = static_cast<long long>(h) - base_ + bias_;
+			}
+			store_(bytes, i, stored);
+
+			if (h < min_height) min_height = h;
+			if (h > max_height) max_height = h;
+		}
+
+		// Stored again offset from the lowest height, front to back, since
+		// the result never takes more bytes per cell.
+		long long range = static_cast<long long>(max_height) - min_height;
+		int final_bytes = range <= 0xFF ? 1 : range <= 0xFFFF ? 2 : 4;
+		long long shift = static_cast<long long>(base_) - bias_ - min_height;
+		int reading = bytes;
+
+		for (long long i = 0; i < cells; i++)
+			store_(final_bytes, i, load_(reading, i) + shift);
+
+		bytes = final_bytes;
+		if (auto shrunk = realloc(data_, cells * bytes))
+			data_ = static_cast<unsigned char *>(shrunk);
+
+		return true;
+	}
+
+	// The heights as T offsets from min_height, where T has bytes bytes.
+	template <typename T>
+	const T *cells() const {
+		return reinterpret_cast<const T *>(data_);
+	}
+
+	long long memory_bytes() const {
+		return static_cast<long long>(width) * height * bytes;
+	}
+
+	const int width, height;
+	int bytes = 0;
+	int min_height = 0, max_height = 0;
+
+private:
+	static long long largest_(int bytes) {
+		return bytes == 4 ? 0xFFFFFFFFLL : (1LL << (8 * bytes)) - 1;
+	}
+
+	long long load_(int bytes, long long i) const {
+		if (bytes == 1) return data_[i];
+		if (bytes == 2) return reinterpret_cast<const unsigned short *>(data_)[i];
+		return reinterpret_cast<const unsigned int *>(data_)[i];
+	}
+
+	void store_(int bytes, long long i, long long stored) {
+		if (bytes == 1) data_[i] = stored;
+		else if (bytes == 2) reinterpret_cast<unsigned short *>(data_)[i] = stored;
+		else reinterpret_cast<unsigned int *>(data_)[i] = stored;
+	}
+
+	// Moves up to the next width, with the n heights read so far. Four
+	// byte heights are offset from 0, so that any int fits.
+	bool widen_(long long n) {
+		int wider = bytes * 2;
+		auto grown = static_cast<unsigned char *>(
+				realloc(data_, static_cast<long long>(width) * height * wider));
+		if (!grown) return false;
+		data_ = grown;
+
+		int new_base = wider == 4 ? 0 : base_;
+		long long new_bias = wider == 4 ? 0x80000000LL : 1LL << (8 * wider - 1);
+		long long shift = new_bias - bias_ + base_ - new_base;
+
+		// Back to front, so that nothing is overwritten before it's read.
+		for (long long i = n - 1; i >= 0; i--)
+			store_(wider, i, load_(bytes, i) + shift);
+
+		bytes = wider;
+		base_ = new_base;
+		bias_ = new_bias;
+		return true;
+	}
+
+	unsigned char *data_ = nullptr;
+	int base_ = 0;
+	long long bias_ = 0;
+};
+
+// The lifts of a lean_map, pruned and ordered like map::index_lifts() does,
+// but without an array over all cells: the cells with any lifts leaving
+// them are kept in a sorted array, along with where their lifts start.
+struct sparse_lifts {
+	sparse_lifts(int width, int height, int n_lifts)
+	: width{width}, height{height}, lifts_{new lift[n_lifts > 0 ? n_lifts : 1]}
+	, capacity_{n_lifts} { }
+
+	sparse_lifts(const sparse_lifts &other) = delete;
+	sparse_lifts(sparse_lifts &&other) = delete;
+	sparse_lifts &operator=(const sparse_lifts &other) = delete;
+	sparse_lifts &operator=(sparse_lifts &&other) = delete;
+
+	~sparse_lifts() {
+		delete[] lifts_;
+		delete[] origins_;
+		delete[] starts_;
+	}
+
+	// Reads n_lifts lifts, and indexes them.
+	bool read(input_reader &in) {
+		for (int i = 0; i < capacity_; i++) {
+			lift &l = lifts_[i];
+			if (!(in.read_int(l.from.x) && in.read_int(l.from.y)
+						&& in.read_int(l.to.x) && in.read_int(l.to.y)
+						&& in.read_int(l.travel_time) && in.read_int(l.leaves_every)))
+				return false;
+		}
+
+		index_();
+		return true;
+	}
+
+	// The lifts leaving the given cell.
+	lift_range from(vertex v) const {
+		int cell = v.x + width * v.y;
+		int lo = 0, hi = n_origins_;
+
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+			if (origins_[mid] < cell) lo = mid + 1;
+			else hi = mid;
+		}
+
+		if (lo == n_origins_ || origins_[lo] != cell) return {lifts_, lifts_};
+		return {lifts_ + starts_[lo], lifts_ + starts_[lo + 1]};
+	}
+
+	int size() const {
+		return n_;
+	}
+
+	int max_edge() const {
+		return max_edge_;
+	}
+
+	long long memory_bytes() const {
+		return static_cast<long long>(n_) * sizeof(lift)
+			+ (2LL * n_origins_ + 1) * sizeof(int);
+	}
+
+	const int width, height;
+
+private:
+	int cell_(vertex v) const {
+		return v.x + width * v.y;
+	}
+
+	void index_() {
+		heap_sort(lifts_, capacity_, [&] (lift a, lift b) {
+			if (!(a.from == b.from)) return cell_(a.from) < cell_(b.from);
+			if (!(a.to == b.to)) return cell_(a.to) < cell_(b.to);
+			if (a.travel_time != b.travel_time) return a.travel_time < b.travel_time;
+			return a.leaves_every < b.leaves_every;
+		});
+
+		// Sorted by travel time within each group, a lift can only be
+		// dominated by the ones already kept, like in map::index_lifts().
+		int group_start = 0;
+		n_origins_ = 0;
+
+		for (int i = 0; i < capacity_; i++) {
+			lift l = lifts_[i];
+			if (n_ && !(lifts_[n_ - 1].from == l.from && lifts_[n_ - 1].to == l.to))
+				group_start = n_;
+
+			bool dominated = false;
+			for (int d = group_start; d < n_ && !dominated; d++)
+				dominated = lifts_[d].dominates(l);
+			if (dominated) continue;
+
+			if (!n_ || !(lifts_[n_ - 1].from == l.from)) n_origins_++;
+
+			int worst = l.leaves_every - 1 + l.travel_time;
+			if (worst > max_edge_) max_edge_ = worst;
+			lifts_[n_++] = l;
+		}
+
+		lift *compact = new lift[n_ > 0 ? n_ : 1];
+		for (int i = 0; i < n_; i++) compact[i] = lifts_[i];
+		delete[] lifts_;
+		lifts_ = compact;
+
+		origins_ = new int[n_origins_ > 0 ? n_origins_ : 1];
+		starts_ = new int[n_origins_ + 1];
+
+		int o = 0;
+		for (int i = 0; i < n_; i++) {
+			if (i && lifts_[i - 1].from == lifts_[i].from) continue;
+
+			origins_[o] = cell_(lifts_[i].from);
+			starts_[o++] = i;
+		}
+		starts_[o] = n_;
+	}
+
+	lift *lifts_;
+	const int capacity_;
+	int n_ = 0;
+	int max_edge_ = 0;
+
+	// The cells with lifts leaving them, ascending, and where their lifts
+	// start in lifts_.
+	int *origins_ = nullptr;
+	int *starts_ = nullptr;
+	int n_origins_ = 0;
+};
+
+// The graph of a map read into narrow_heights and sparse_lifts, which both
+// have to outlive it, with T the type of the stored heights (unsigned char,
+// unsigned short or unsigned int, see narrow_heights::bytes).
+template <typename T>
+struct lean_map {
+	using layout = row_major;
+
+	lean_map(const narrow_heights &heights, const sparse_lifts &lifts)
+	: width{heights.width}, height{heights.height}, n_lifts{lifts.size()}
+	, heights_{heights.cells<T>()}, lifts_{lifts}
+	, max_grid_edge_{static_cast<long long>(heights.max_height) - heights.min_height + 1} { }
+
+	// Too large for an int only if the heights span the whole range of
+	// ints, in which case Dial's algorithm is out of the question anyway.
+	int max_edge() const {
+		long long lift = lifts_.max_edge();
+		long long edge = max_grid_edge_ > lift ? max_grid_edge_ : lift;
+		return edge < INT_MAX ? edge : INT_MAX;
+	}
+
+	// Same as map::compute_neighbors.
+	void compute_neighbors(int time, vertex from, fixed_vector<neighbor> &out) const {
+		long long i = from.x + static_cast<long long>(width) * from.y;
+		T B = heights_[i];
+		out.clear();
+
+		auto insert_grid_edge = [&] (vertex to, long long j) {
+			T A = heights_[j];
+			out.push({to, A > B ? static_cast<int>(A - B) + 1 : 1});
+		};
+
+		if (from.x > 0) insert_grid_edge({from.x - 1, from.y}, i - 1);
+		if (from.x + 1 < width) insert_grid_edge({from.x + 1, from.y}, i + 1);
+		if (from.y > 0) insert_grid_edge({from.x, from.y - 1}, i - width);
+		if (from.y + 1 < height) insert_grid_edge({from.x, from.y + 1}, i + width);
+
+		for (auto &l : lifts_.from(from))
+			out.push({l.to, l.wait(time) + l.travel_time});
+	}
+
+	// Time of the walk from source along its row, then along the target's
+	// column, an upper bound on the answer.
+	long long walk_time(vertex source, vertex target) const {
+		long long time = 0;
+		vertex v = source;
+
+		auto step = [&] (vertex to) {
+			T A = heights_[to.x + static_cast<long long>(width) * to.y];
+			T B = heights_[v.x + static_cast<long long>(width) * v.y];
+			time += A > B ? static_cast<long long>(A - B) + 1 : 1;
+			v = to;
+		};
+
+		while (v.x != target.x) step({v.x + (target.x > v.x ? 1 : -1), v.y});
+		while (v.y != target.y) step({v.x, v.y + (target.y > v.y ? 1 : -1)});
+
+		return time;
+	}
+
+	const int width, height;
+	const int n_lifts;
+
+private:
+	const T *const heights_;
+	const sparse_lifts &lifts_;
+	const long long max_grid_edge_;
+};
+
+// Distances stored in T, unsigned short or int, without epochs, so reset()
+// has to write every entry. Cells not reached yet read as the largest T
+// rather than as INT_MAX, so a search never stores anything that far: with
+// unsigned short, that's only exact for targets known to be closer.
+template <typename T>
+struct narrow_distances {
+	static constexpr int unreached = sizeof(T) == 2 ? 0xFFFF : INT_MAX;
+
+	narrow_distances(int width, int height)
+	: width_{width}, entries_{new T[static_cast<long long>(width) * height]}
+	, size_{static_cast<long long>(width) * height} {
+		reset();
+	}
+
+	narrow_distances(const narrow_distances &other) = delete;
+	narrow_distances(narrow_distances &&other) = delete;
+	narrow_distances &operator=(const narrow_distances &other) = delete;
+	narrow_distances &operator=(narrow_distances &&other) = delete;
+
+	~narrow_distances() {
+		delete[] entries_;
+	}
+
+	void reset() {
+		for (long long i = 0; i < size_; i++)
+			entries_[i] = unreached;
+	}
+
+	int operator[](vertex v) const {
+		return entries_[v.x + static_cast<long long>(width_) * v.y];
+	}
+
+	void set(vertex v, int dist) {
+		entries_[v.x + static_cast<long long>(width_) * v.y] = dist;
+	}
+
+	long long memory_bytes() const {
+		return size_ * sizeof(T);
+	}
+
+private:
+	const int width_;
+	T *const entries_;
+	const long long size_;
+};
+
+// Answers queries on a lean_map, with 2 byte distances whenever the walk
+// along the row and the column shows that the answer fits, and 4 byte ones
+// otherwise. Only one of the two is allocated at a time.
+template <typename T>
+struct lean_router {
+	explicit lean_router(const lean_map<T> &m)
+	: m_{m} { }
+
+	lean_router(const lean_router &other) = delete;
+	lean_router(lean_router &&other) = delete;
+	lean_router &operator=(const lean_router &other) = delete;
+	lean_router &operator=(lean_router &&other) = delete;
+
+	~lean_router() {
+		delete narrow_;
+		delete wide_;
+	}
+
+	search_result route(vertex source, vertex target) {
+		if (m_.walk_time(source, target) < narrow_distances<unsigned short>::unreached) {
+			delete wide_;
+			wide_ = nullptr;
+			if (!narrow_) narrow_ = new narrow_state{m_};
+
+			return dijkstra(m_, source, target, *narrow_);
+		}
+
+		delete narrow_;
+		narrow_ = nullptr;
+		if (!wide_) wide_ = new wide_state{m_};
+
+		return dijkstra(m_, source, target, *wide_);
+	}
+
+private:
+	using narrow_state = search_state<radix_heap, row_major, narrow_distances<unsigned short>>;
+	using wide_state = search_state<radix_heap, row_major, narrow_distances<int>>;
+
+	const lean_map<T> &m_;
+	narrow_state *narrow_ = nullptr;
+	wide_state *wide_ = nullptr;
+};
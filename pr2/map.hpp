@@ -0,0 +1,511 @@
+#pragma once
+
+#include "../common/fast_io.hpp"
+#include "containers.hpp"
+#include "layout.hpp"
+#include "stats.hpp"
+#include "types.hpp"
+
+// The first line of the input: map size, the query, and the lift count.
+struct map_header {
+	bool read(input_reader &in) {
+		return in.read_int(width) && in.read_int(height)
+			&& in.read_int(start.x) && in.read_int(start.y)
+			&& in.read_int(end.x) && in.read_int(end.y)
+			&& in.read_int(n_lifts);
+	}
+
+	int width, height;
+	vertex start, end;
+	int n_lifts;
+};
+
+// The lifts leaving a single cell, or all of the lifts on the map.
+struct lift_range {
+	const lift *begin() const {
+		return first;
+	}
+
+	const lift *end() const {
+		return last;
+	}
+
+	int size() const {
+		return static_cast<int>(last - first);
+	}
+
+	const lift *first, *last;
+};
+
+// Layout is the layout of the heights and of the lift index (see layout.hpp).
+// Everything outside of benchmarks uses the row-major map.
+template <typename Layout>
+struct basic_map {
+	using layout = Layout;
+
+	basic_map(int width, int height, int n_lifts)
+	: width{width}, height{height}, n_lifts{n_lifts}
+	, heights{width, height}
+	, lift_offsets_{new int[heights.size + 1]{}}
+	, lifts_{new lift[n_lifts]} { }
+
+	basic_map(const basic_map &other) = delete;
+	basic_map(basic_map &&other) = delete;
+
+	basic_map &operator=(const basic_map &other) = delete;
+	basic_map &operator=(basic_map &&other) = delete;
+
+	~basic_map() {
+		delete[] lift_offsets_;
+		delete[] lifts_;
+
+		drop_reverse_lifts_();
+	}
+
+	void read_lifts(input_reader &in) {
+		for (int i = 0; i < n_lifts; i++) {
+			lift l{};
+			in.read_int(l.from.x); in.read_int(l.from.y);
+			in.read_int(l.to.x); in.read_int(l.to.y);
+			in.read_int(l.travel_time);
+			in.read_int(l.leaves_every);
+
+			add_lift(l);
+		}
+
+		index_lifts();
+	}
+
+	void read_heights(input_reader &in) {
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++)
+				in.read_int(heights[{x, y}]);
+		}
+
+		update_height_range_();
+	}
+
+	// Adds a single lift, at most n_lifts in total, before index_lifts().
+	// Used by read_lifts() and by map_generator and copies of maps, which
+	// then have to call index_lifts() themselves.
+	void add_lift(const lift &l) {
+		lifts_[n_indexed_lifts_++] = l;
+	}
+
+	// Groups the added lifts by origin and destination, and drops every
+	// lift which is never better than another one between the same cells:
+	// one that is never faster, whatever the arrival time (see
+	// lift::dominates). What's left is stored in one array, ordered by the
+	// origin and destination (in layout order), with the lifts leaving each
+	// cell next to each other.
+	//
+	// The dropped lifts are kept aside, in case remove_lift() takes away
+	// the one that made them useless.
+	void index_lifts() {
+		int n = n_indexed_lifts_;
+		lift *sorted = new lift[n];
+
+		// Stable counting sorts, first by destination and then by origin.
+		auto counting_sort = [&] (lift *from, lift *to, auto key) {
+			for (int i = 0; i <= heights.size; i++) lift_offsets_[i] = 0;
+			for (int i = 0; i < n; i++) lift_offsets_[key(from[i]) + 1]++;
+			for (int i = 0; i < heights.size; i++) lift_offsets_[i + 1] += lift_offsets_[i];
+			for (int i = 0; i < n; i++) to[lift_offsets_[key(from[i])]++] = from[i];
+		};
+
+		counting_sort(lifts_, sorted, [&] (lift l) { return heights.layout(l.to); });
+		counting_sort(sorted, lifts_, [&] (lift l) { return heights.layout(l.from); });
+		delete[] sorted;
+
+		// Pruned lifts are moved down in place, and lift_offsets_ is
+		// refilled as the origins are passed.
+		int kept = 0, cell = 0;
+		max_lift_edge_ = 0;
+		timed_lifts_ = false;
+
+		for (int i = 0, j; i < n; i = j) {
+			lift *group = lifts_ + i;
+			for (j = i + 1; j < n && lifts_[j].from == group->from && lifts_[j].to == group->to; j++)
+				;
+
+			int origin = heights.layout(group->from);
+			while (cell <= origin) lift_offsets_[cell++] = kept;
+
+			// With the group sorted by travel time, a lift can only be
+			// dominated by the ones already kept.
+			sort_by_travel_time_(group, j - i);
+
+			int first_kept = kept;
+			for (int k = 0; k < j - i; k++) {
+				lift l = group[k];
+
+				bool dominated = false;
+				for (int d_i = first_kept; d_i < kept && !dominated; d_i++)
+					dominated = lifts_[d_i].dominates(l);
+
+				if (dominated) {
+					dominated_lifts_.push(l);
+					continue;
+				}
+
+				note_lift_(l);
+				lifts_[kept++] = l;
+			}
+		}
+
+		while (cell <= heights.size) lift_offsets_[cell++] = kept;
+		n_indexed_lifts_ = kept;
+
+		lift *compact = new lift[kept];
+		for (int i = 0; i < kept; i++) compact[i] = lifts_[i];
+
+		delete[] lifts_;
+		lifts_ = compact;
+	}
+
+	// Takes lifts already grouped and pruned the way index_lifts() leaves
+	// them, as all_lifts() returns them, instead of add_lift() and
+	// index_lifts(), so that they're only copied and not sorted or pruned
+	// again. At most n_lifts of them. Returns false if they aren't ordered
+	// by origin and then destination, after which the map's lifts mustn't
+	// be used.
+	bool adopt_indexed_lifts(const lift *lifts, int n) {
+		int cell = 0;
+		max_lift_edge_ = 0;
+		timed_lifts_ = false;
+
+		for (int i = 0; i < n; i++) {
+			lift l = lifts[i];
+			int origin = heights.layout(l.from);
+
+			if (i) {
+				int previous = heights.layout(lifts[i - 1].from);
+				if (origin < previous) return false;
+				if (origin == previous && heights.layout(l.to) < heights.layout(lifts[i - 1].to))
+					return false;
+			}
+
+			while (cell <= origin) lift_offsets_[cell++] = i;
+			note_lift_(l);
+			lifts_[i] = l;
+		}
+
+		while (cell <= heights.size) lift_offsets_[cell++] = n;
+		n_indexed_lifts_ = n;
+		return true;
+	}
+
+	// The lifts leaving the given cell, only valid after index_lifts().
+	lift_range lifts_from(vertex from) const {
+		int i = heights.layout(from);
+		return {lifts_ + lift_offsets_[i], lifts_ + lift_offsets_[i + 1]};
+	}
+
+	// Every lift left after index_lifts(), grouped by origin.
+	lift_range all_lifts() const {
+		return {lifts_, lifts_ + n_indexed_lifts_};
+	}
+
+	// Edits, for after the map has been read. Searches must not run while
+	// the map is being edited, and anything built from the map before an
+	// edit, like a compact_graph, landmarks or a search_state (which has
+	// room for n_lifts edges), is out of date after it. max_edge() stays
+	// an upper bound, but may no longer be tight.
+	void set_height(vertex v, int h) {
+		heights[v] = h;
+		if (h < min_height_) min_height_ = h;
+		if (h > max_height_) max_height_ = h;
+	}
+
+	// Adds a lift after index_lifts(), keeping the index pruned.
+	void insert_lift(const lift &l) {
+		n_lifts++;
+		reindex_group_(l.from, l.to, &l, nullptr);
+	}
+
+	// Removes a lift equal to the given one, returning false if there's
+	// no such lift. Lifts only dropped because of it are brought back.
+	bool remove_lift(const lift &l) {
+		if (!reindex_group_(l.from, l.to, nullptr, &l)) return false;
+
+		n_lifts--;
+		return true;
+	}
+
+	// Fills in all heights from a row-major plane of stored heights, each
+	// of which is offset from the actual height by offset. The equivalent
+	// of read_heights() for loaders of other formats.
+	template <typename T>
+	void load_heights(const T *plane, int offset) {
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++)
+				heights[{x, y}] = *plane++ + offset;
+		}
+
+		update_height_range_();
+	}
+
+	// Upper bound on the time of any grid edge, only valid after
+	// read_heights().
+	int max_grid_edge() const {
+		return max_height_ - min_height_ + 1;
+	}
+
+	// Upper bound on the time of any edge returned by compute_neighbors,
+	// only valid after both read_lifts() and read_heights().
+	int max_edge() const {
+		int grid = max_grid_edge();
+		return grid > max_lift_edge_ ? grid : max_lift_edge_;
+	}
+
+	// Memory taken up by the heights and the lifts.
+	long long memory_bytes() const {
+		return static_cast<long long>(heights.size) * sizeof(int)
+			+ static_cast<long long>(heights.size + 1) * sizeof(int)
+			+ static_cast<long long>(n_indexed_lifts_ + dominated_lifts_.size()) * sizeof(lift);
+	}
+
+	// Fills out with the edges leaving the given vertex, when arriving
+	// there at the given time. out must have room for 4 + n_lifts edges.
+	// Only reads the map, so concurrent searches can share it as long as
+	// each brings its own out buffer.
+	void compute_neighbors(int time, vertex from, fixed_vector<neighbor> &out) const {
+		int B = heights[from];
+		out.clear();
+
+		auto insert_grid_edge = [&] (vertex to) {
+			if (to.x < 0 || to.x >= width) return;
+			if (to.y < 0 || to.y >= height) return;
+			int A = heights[to];
+
+			out.push({to, A > B ? A - B + 1 : 1});
+		};
+
+		auto insert_lift_edge = [&] (lift l) {
+			out.push({l.to, l.wait(time) + l.travel_time});
+		};
+
+		insert_grid_edge({from.x - 1, from.y});
+		insert_grid_edge({from.x + 1, from.y});
+		insert_grid_edge({from.x, from.y - 1});
+		insert_grid_edge({from.x, from.y + 1});
+
+		auto lifts = lifts_from(from);
+		stats::lift_edges(lifts.size());
+		for (auto lift : lifts) insert_lift_edge(lift);
+	}
+
+	// Whether any lift has to be waited for, i.e. the edge weights depend
+	// on the arrival time. If not, every lift edge costs its travel time.
+	bool has_timed_lifts() const {
+		return timed_lifts_;
+	}
+
+	// Like compute_neighbors, but fills out with the edges leading into the
+	// given vertex, for searching backwards from the target. Since the
+	// departure time is not known when searching backwards, lift edges
+	// cost just their travel time, which is exact only for maps without
+	// timed lifts, and a lower bound otherwise. The first call builds an
+	// index of lifts by destination, so it must not race with other calls.
+	void compute_reverse_neighbors(vertex to, fixed_vector<neighbor> &out) const {
+		int A = heights[to];
+		out.clear();
+
+		auto insert_grid_edge = [&] (vertex from) {
+			if (from.x < 0 || from.x >= width) return;
+			if (from.y < 0 || from.y >= height) return;
+			int B = heights[from];
+
+			out.push({from, A > B ? A - B + 1 : 1});
+		};
+
+		insert_grid_edge({to.x - 1, to.y});
+		insert_grid_edge({to.x + 1, to.y});
+		insert_grid_edge({to.x, to.y - 1});
+		insert_grid_edge({to.x, to.y + 1});
+
+		for (auto lift : lifts_to(to))
+			out.push({lift.from, lift.travel_time});
+	}
+
+	// The lifts arriving at the given cell. Like compute_reverse_neighbors,
+	// the first call builds the index, so it must not race with other calls.
+	lift_range lifts_to(vertex to) const {
+		if (!reverse_offsets_) build_reverse_lifts_();
+
+		int i = heights.layout(to);
+		return {reverse_lifts_ + reverse_offsets_[i], reverse_lifts_ + reverse_offsets_[i + 1]};
+	}
+
+	const int width, height;
+	// Including the ones index_lifts() dropped, so at least the number of
+	// lifts leaving any one cell. Changed by insert_lift() and remove_lift().
+	int n_lifts;
+	array2d<int, Layout> heights;
+
+private:
+	void note_lift_(lift l) {
+		int worst = l.leaves_every - 1 + l.travel_time;
+		if (worst > max_lift_edge_) max_lift_edge_ = worst;
+		if (l.leaves_every > 1) timed_lifts_ = true;
+	}
+
+	// Prunes the lifts from one cell to another again, after adding added
+	// or removing one lift equal to removed, and splices what's kept back
+	// into the index. Returns false if there was nothing to remove.
+	bool reindex_group_(vertex from, vertex to, const lift *added, const lift *removed) {
+		dynamic_vector<lift> group;
+		auto equal = [] (lift a, lift b) {
+			return a.from == b.from && a.to == b.to
+				&& a.travel_time == b.travel_time && a.leaves_every == b.leaves_every;
+		};
+
+		// The group within the cell's lifts, which are ordered by
+		// destination.
+		int origin = heights.layout(from);
+		int first = lift_offsets_[origin], last = lift_offsets_[origin + 1];
+		while (first < last && heights.layout(lifts_[first].to) < heights.layout(to)) first++;
+		int end = first;
+		while (end < last && lifts_[end].to == to) group.push(lifts_[end++]);
+
+		for (int i = 0; i < dominated_lifts_.size(); ) {
+			lift l = dominated_lifts_[i];
+			if (l.from == from && l.to == to) {
+				group.push(l);
+				dominated_lifts_[i] = dominated_lifts_[dominated_lifts_.size() - 1];
+				dominated_lifts_.pop();
+			} else {
+				i++;
+			}
+		}
+
+		bool found = !removed;
+		if (added) group.push(*added);
+		for (int i = 0; i < group.size() && !found; i++) {
+			if (equal(group[i], *removed)) {
+				group[i] = group[group.size() - 1];
+				group.pop();
+				found = true;
+			}
+		}
+
+		sort_by_travel_time_(group.begin(), group.size());
+
+		int kept = 0;
+		for (int k = 0; k < group.size(); k++) {
+			lift l = group[k];
+
+			bool dominated = false;
+			for (int d_i = 0; d_i < kept && !dominated; d_i++)
+				dominated = group[d_i].dominates(l);
+
+			if (dominated) {
+				dominated_lifts_.push(l);
+				continue;
+			}
+
+			note_lift_(l);
+			group[kept++] = l;
+		}
+
+		int delta = kept - (end - first);
+		splice_(lifts_, lift_offsets_, n_indexed_lifts_, origin, first, end, group.begin(), kept);
+
+		// The reverse index, if it's been built, has the same group
+		// somewhere among the lifts into the destination.
+		if (reverse_offsets_) {
+			int dest = heights.layout(to);
+			int r_first = reverse_offsets_[dest], r_last = reverse_offsets_[dest + 1];
+			while (r_first < r_last && !(reverse_lifts_[r_first].from == from)) r_first++;
+			if (r_first == r_last) r_first = reverse_offsets_[dest];
+
+			int r_end = r_first;
+			while (r_end < r_last && reverse_lifts_[r_end].from == from) r_end++;
+
+			splice_(reverse_lifts_, reverse_offsets_, n_indexed_lifts_, dest,
+					r_first, r_end, group.begin(), kept);
+		}
+
+		n_indexed_lifts_ += delta;
+		return found;
+	}
+	// Heap sort, since the lifts between a pair of cells can be many.
+	static void sort_by_travel_time_(lift *lifts, int n) {
+		heap_sort(lifts, n, [] (lift a, lift b) {
+			if (a.travel_time != b.travel_time) return a.travel_time < b.travel_time;
+			return a.leaves_every < b.leaves_every;
+		});
+	}
+
+	void update_height_range_() {
+		min_height_ = max_height_ = heights[{0, 0}];
+
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				int h = heights[{x, y}];
+				if (h < min_height_) min_height_ = h;
+				if (h > max_height_) max_height_ = h;
+			}
+		}
+	}
+
+	// Same as lifts_, but grouped by the destination. Only built once
+	// lifts_to is first used.
+	void build_reverse_lifts_() const {
+		auto offsets = new int[heights.size + 1]{};
+		reverse_lifts_ = new lift[n_indexed_lifts_];
+
+		// After the prefix sums, offsets[i] is the end of the group of
+		// cell i. Each group is then filled from its end, leaving offsets[i]
+		// at its start.
+		for (auto l : all_lifts()) offsets[heights.layout(l.to)]++;
+		for (int i = 0; i < heights.size; i++) offsets[i + 1] += offsets[i];
+		for (auto l : all_lifts()) reverse_lifts_[--offsets[heights.layout(l.to)]] = l;
+
+		reverse_offsets_ = offsets;
+	}
+
+	// Replaces lifts [first, end) of an index of n lifts with count others,
+	// moving the lifts of the cells after the given one along.
+	void splice_(lift *&lifts, int *offsets, int n, int cell, int first, int end,
+			const lift *others, int count) const {
+		int delta = count - (end - first);
+		lift *spliced = new lift[n + delta > 0 ? n + delta : 1];
+
+		for (int i = 0; i < first; i++) spliced[i] = lifts[i];
+		for (int i = 0; i < count; i++) spliced[first + i] = others[i];
+		for (int i = end; i < n; i++) spliced[i + delta] = lifts[i];
+
+		delete[] lifts;
+		lifts = spliced;
+
+		if (delta) {
+			for (int i = cell + 1; i <= heights.size; i++) offsets[i] += delta;
+		}
+	}
+
+	void drop_reverse_lifts_() {
+		delete[] reverse_offsets_;
+		delete[] reverse_lifts_;
+		reverse_offsets_ = nullptr;
+		reverse_lifts_ = nullptr;
+	}
+
+	mutable int *reverse_offsets_ = nullptr;
+	mutable lift *reverse_lifts_ = nullptr;
+
+	// Before index_lifts(), lifts_ has room for n_lifts, and holds the
+	// n_indexed_lifts_ added so far. After, it holds just the lifts that
+	// were kept, and those leaving the cell at layout index i are at
+	// [lift_offsets_[i], lift_offsets_[i + 1]).
+	int *const lift_offsets_;
+	lift *lifts_;
+	int n_indexed_lifts_ = 0;
+	dynamic_vector<lift> dominated_lifts_;
+
+	int min_height_ = 0, max_height_ = 0;
+	int max_lift_edge_ = 0;
+	bool timed_lifts_ = false;
+};
+
+using map = basic_map<row_major>;
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstdio>     // fprintf
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+#include "../common/fast_io.hpp"
+#include "map.hpp"
+#include "types.hpp"
+
+// Binary map format, meant to be written once from the text format and
+// then loaded without any parsing. All fields are in the native byte
+// order of the machine that wrote the file, which the loader checks.
+//
+//	header
+//	heights: width * height unsigned integers of height_bytes bytes each,
+//	         row-major, each offset from the actual height by
+//	         -height_offset (height_bytes is the smallest of 1, 2 or 4
+//	         that fits the range of heights)
+//	padding to a multiple of 4 bytes
+//	lifts:   n_lifts lift structs, sorted by origin (row-major), then by
+//	         destination, without dominated lifts (see index_lifts())
+namespace map_file {
+
+constexpr char magic[8] = {'P', 'R', '2', 'M', 'A', 'P', '\r', '\n'};
+constexpr unsigned int version = 1;
+constexpr unsigned int byte_order = 0x01020304;
+
+struct header {
+	char magic[8];
+	unsigned int version;
+	unsigned int byte_order;
+
+	int width, height;
+	vertex start, end;
+	int n_lifts;
+
+	unsigned int height_bytes;
+	int height_offset;
+	unsigned int reserved[3];
+};
+
+static_assert(sizeof(header) == 64, "the header layout is part of the format");
+static_assert(sizeof(lift) == 24, "the lift layout is part of the format");
+
+inline long long heights_offset() {
+	return sizeof(header);
+}
+
+inline long long lifts_offset(const header &h) {
+	long long end = heights_offset()
+		+ static_cast<long long>(h.width) * h.height * h.height_bytes;
+	return (end + 3) & ~3LL;
+}
+
+inline long long file_size(const header &h) {
+	return lifts_offset(h) + static_cast<long long>(h.n_lifts) * sizeof(lift);
+}
+
+// Writes the map along with the query from its header into the file at
+// path. Prints what went wrong and returns false on failure.
+inline bool save(const map &m, const map_header &query, const char *path) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "%s: failed to open for writing\n", path);
+		return false;
+	}
+
+	int cells = m.width * m.height;
+	int min = m.heights.data[0], max = m.heights.data[0];
+	for (int i = 1; i < cells; i++) {
+		if (m.heights.data[i] < min) min = m.heights.data[i];
+		if (m.heights.data[i] > max) max = m.heights.data[i];
+	}
+
+	long long range = static_cast<long long>(max) - min;
+
+	header h{};
+	for (int i = 0; i < 8; i++) h.magic[i] = magic[i];
+	h.version = version;
+	h.byte_order = byte_order;
+	h.width = m.width;
+	h.height = m.height;
+	h.start = query.start;
+	h.end = query.end;
+	h.n_lifts = m.all_lifts().size();
+	h.height_bytes = range <= 0xFF ? 1 : range <= 0xFFFF ? 2 : 4;
+	// Four byte heights are stored as they are.
+	h.height_offset = h.height_bytes == 4 ? 0 : min;
+
+	output_writer out{fd};
+	out.write_bytes(&h, sizeof(h));
+
+	for (int i = 0; i < cells; i++) {
+		int stored = m.heights.data[i] - h.height_offset;
+
+		if (h.height_bytes == 1) {
+			unsigned char narrow = stored;
+			out.write_bytes(&narrow, 1);
+		} else if (h.height_bytes == 2) {
+			unsigned short narrow = stored;
+			out.write_bytes(&narrow, 2);
+		} else {
+			out.write_bytes(&stored, 4);
+		}
+	}
+
+	for (long long i = heights_offset() + cells * h.height_bytes; i < lifts_offset(h); i++)
+		out.write_char('\0');
+
+	// The map's lifts are already sorted by origin and then destination,
+	// in row-major order, and pruned.
+	auto lifts = m.all_lifts();
+	out.write_bytes(lifts.begin(), static_cast<long long>(lifts.size()) * sizeof(lift));
+
+	bool ok = out.flush();
+	if (close(fd) < 0) ok = false;
+
+	if (!ok) fprintf(stderr, "%s: failed to write\n", path);
+	return ok;
+}
+
+// Checks everything that the rest of pr2 relies on, so that a corrupt or
+// truncated file can't lead to out of bounds accesses later.
+inline const char *validate(const header &h, long long size) {
+	if (size < static_cast<long long>(sizeof(header))) return "file too small for the header";
+
+	for (int i = 0; i < 8; i++)
+		if (h.magic[i] != magic[i]) return "not a binary map file";
+
+	if (h.byte_order != byte_order) return "written on a machine with a different byte order";
+	if (h.version != version) return "unsupported format version";
+
+	if (h.width <= 0 || h.height <= 0) return "invalid map size";
+	if (static_cast<long long>(h.width) * h.height > 0x7FFFFFFF) return "map too large";
+	if (h.n_lifts < 0) return "invalid lift count";
+	if (h.height_bytes != 1 && h.height_bytes != 2 && h.height_bytes != 4)
+		return "invalid height width";
+
+	auto in_bounds = [&] (vertex v) {
+		return v.x >= 0 && v.x < h.width && v.y >= 0 && v.y < h.height;
+	};
+
+	if (!in_bounds(h.start) || !in_bounds(h.end)) return "query out of bounds";
+	if (size != file_size(h)) return "file size doesn't match the header";
+
+	return nullptr;
+}
+
+// Loads a map written by save(), along with its query. Prints what went
+// wrong and returns nullptr on failure.
+inline map *load(const char *path, map_header &query) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "%s: failed to open\n", path);
+		return nullptr;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size < static_cast<long long>(sizeof(header))) {
+		fprintf(stderr, "%s: file too small for the header\n", path);
+		close(fd);
+		return nullptr;
+	}
+
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "%s: failed to map\n", path);
+		return nullptr;
+	}
+
+	auto base = static_cast<const char *>(data);
+	auto &h = *reinterpret_cast<const header *>(base);
+
+	if (auto error = validate(h, st.st_size)) {
+		fprintf(stderr, "%s: %s\n", path, error);
+		munmap(data, st.st_size);
+		return nullptr;
+	}
+
+	auto lifts = reinterpret_cast<const lift *>(base + lifts_offset(h));
+	for (int i = 0; i < h.n_lifts; i++) {
+		auto l = lifts[i];
+		bool valid = l.from.x >= 0 && l.from.x < h.width && l.from.y >= 0 && l.from.y < h.height
+			&& l.to.x >= 0 && l.to.x < h.width && l.to.y >= 0 && l.to.y < h.height
+			&& l.leaves_every > 0 && l.travel_time >= 0;
+
+		if (!valid) {
+			fprintf(stderr, "%s: lift %d is invalid\n", path, i);
+			munmap(data, st.st_size);
+			return nullptr;
+		}
+	}
+
+	query = {h.width, h.height, h.start, h.end, h.n_lifts};
+
+	auto m = new map{h.width, h.height, h.n_lifts};
+	auto plane = base + heights_offset();
+
+	if (h.height_bytes == 1)
+		m->load_heights(reinterpret_cast<const unsigned char *>(plane), h.height_offset);
+	else if (h.height_bytes == 2)
+		m->load_heights(reinterpret_cast<const unsigned short *>(plane), h.height_offset);
+	else
+		m->load_heights(reinterpret_cast<const int *>(plane), h.height_offset);
+
+	// The lifts were indexed before they were saved.
+	bool sorted = m->adopt_indexed_lifts(lifts, h.n_lifts);
+	munmap(data, st.st_size);
+
+	if (!sorted) {
+		fprintf(stderr, "%s: lifts aren't sorted by origin and destination\n", path);
+		delete m;
+		return nullptr;
+	}
+
+	return m;
+}
+
+} // namespace map_file
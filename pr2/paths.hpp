@@ -0,0 +1,309 @@
+#pragma once
+
+#include <climits>
+#include <cstdio>   // fprintf
+#include <fcntl.h>  // open
+#include <unistd.h> // close
+
+#include "../common/fast_io.hpp"
+#include "containers.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "map.hpp"
+#include "stats.hpp"
+#include "types.hpp"
+
+// How a search reached a vertex: from one of the four grid neighbors, or by
+// a lift. Which lift is only worked out when the path is reconstructed.
+enum class step : unsigned char {
+	none,
+	from_left,
+	from_right,
+	from_above,
+	from_below,
+	via_lift,
+};
+
+// A step per cell, packed into 3 bits each, rather than a whole vertex as
+// the parent pointer. Like distance_table, it isn't cleared between
+// searches, since only cells reached in the last search are ever read.
+struct predecessor_store {
+	predecessor_store(int width, int height)
+	: width{width}, size_{(3LL * width * height + 7) / 8 + 1}
+	, bytes_{new unsigned char[size_]{}} { }
+
+	predecessor_store(const predecessor_store &other) = delete;
+	predecessor_store(predecessor_store &&other) = delete;
+	predecessor_store &operator=(const predecessor_store &other) = delete;
+	predecessor_store &operator=(predecessor_store &&other) = delete;
+
+	~predecessor_store() {
+		delete[] bytes_;
+	}
+
+	// Each entry lies within two consecutive bytes, and there's a byte of
+	// padding at the end for the last one.
+	step get(vertex v) const {
+		long long bit = 3LL * (v.x + width * v.y);
+		unsigned int pair = bytes_[bit >> 3] | bytes_[(bit >> 3) + 1] << 8;
+
+		return static_cast<step>((pair >> (bit & 7)) & 7);
+	}
+
+	void set(vertex v, step s) {
+		long long bit = 3LL * (v.x + width * v.y);
+		unsigned int pair = bytes_[bit >> 3] | bytes_[(bit >> 3) + 1] << 8;
+
+		pair &= ~(7U << (bit & 7));
+		pair |= static_cast<unsigned int>(s) << (bit & 7);
+
+		bytes_[bit >> 3] = pair & 0xFF;
+		bytes_[(bit >> 3) + 1] = pair >> 8;
+	}
+
+	long long memory_bytes() const {
+		return size_;
+	}
+
+	const int width;
+
+private:
+	const long long size_;
+	unsigned char *const bytes_;
+};
+
+// Same as dijkstra() on a map, but also records in preds how every vertex
+// was reached, for reconstruct_path().
+template <typename Queue>
+search_result shortest_path_tree(const map &m, vertex source, vertex target,
+		search_state<Queue> &state, predecessor_store &preds, int departure = 0) {
+	auto &dist = state.dist;
+	auto &Q = state.Q;
+	int settled = 0;
+
+	// An edge to a grid neighbor is a lift only if it costs something other
+	// than walking there. Otherwise, it doesn't matter which one it was.
+	auto step_between = [&] (vertex u, vertex v, int edge) {
+		int dx = v.x - u.x, dy = v.y - u.y;
+		if ((dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy) != 1)
+			return step::via_lift;
+
+		int A = m.heights[v], B = m.heights[u];
+		if (edge != (A > B ? A - B + 1 : 1))
+			return step::via_lift;
+
+		if (dx) return dx > 0 ? step::from_left : step::from_right;
+		return dy > 0 ? step::from_above : step::from_below;
+	};
+
+	Q.clear();
+	dist.reset();
+	stats::queue_cleared();
+
+	Q.insert(departure, source);
+	dist.set(source, departure);
+	preds.set(source, step::none);
+	stats::pushed();
+
+	while (!Q.empty()) {
+		auto [priority, u] = Q.extract_min();
+		int dist_u = dist[u];
+		stats::popped(priority > dist_u);
+		if (priority > dist_u) continue;
+
+		settled++;
+		if (u == target) break;
+
+		m.compute_neighbors(dist_u, u, state.neighbors);
+		stats::relaxed(state.neighbors.size());
+
+		for (auto [v, edge] : state.neighbors) {
+			auto alt = dist_u + edge;
+
+			if (alt < dist[v]) {
+				dist.set(v, alt);
+				bool added = Q.insert(alt, v);
+				preds.set(v, step_between(u, v, edge));
+				stats::inserted(added);
+			}
+		}
+	}
+
+	return {dist[target] - departure, settled};
+}
+
+struct path_step {
+	vertex from, to;
+	bool lift;
+	// Time spent waiting for the lift, always 0 for grid steps.
+	int wait;
+	int arrival;
+	// Of the lift, 1 for grid steps.
+	int leaves_every;
+};
+
+// Fills out with the steps from source to target, after a
+// shortest_path_tree() search between them. Lifts are recovered by looking
+// for one into the vertex that gets there at its distance. Returns false if
+// the target wasn't reached.
+template <typename Layout>
+bool reconstruct_path(const map &m, const distance_table<Layout> &dist,
+		const predecessor_store &preds, vertex source, vertex target,
+		dynamic_vector<path_step> &out) {
+	out.clear();
+	if (dist[target] == INT_MAX) return false;
+
+	auto push_lift = [&] (const lift &l) {
+		out.push({l.from, l.to, true, l.wait(dist[l.from]), dist[l.to], l.leaves_every});
+	};
+
+	// A lift into v from a vertex reached strictly earlier.
+	auto earlier_lift = [&] (vertex v) -> const lift * {
+		for (auto &l : m.lifts_to(v)) {
+			int dist_u = dist[l.from];
+			if (dist_u < dist[v] && dist_u + l.wait(dist_u) + l.travel_time == dist[v])
+				return &l;
+		}
+		return nullptr;
+	};
+
+	// Lifts taking no time at all can leave a group of vertices at the same
+	// distance, reachable from each other, so following any lift that fits
+	// could go around in circles. Instead, search backwards through the
+	// group, breadth first, for a vertex that was reached some other way.
+	struct zero_step {
+		vertex v;
+		int next;
+		const lift *l;
+	};
+	dynamic_vector<zero_step> group;
+
+	auto leave_group = [&] (vertex v) -> vertex {
+		group.clear();
+		group.push({v, -1, nullptr});
+
+		for (int i = 0; i < group.size(); i++) {
+			vertex u = group[i].v;
+			auto s = preds.get(u);
+
+			bool exit = u == source || (s != step::none && s != step::via_lift)
+				|| (s == step::via_lift && earlier_lift(u));
+
+			if (i && exit) {
+				// Steps are pushed from the target backwards, so the
+				// first one pushed is the one into v.
+				dynamic_vector<int> chain;
+				for (int j = i; j > 0; j = group[j].next) chain.push(j);
+				for (int k = chain.size() - 1; k >= 0; k--) push_lift(*group[chain[k]].l);
+
+				return u;
+			}
+
+			for (auto &l : m.lifts_to(u)) {
+				if (dist[l.from] != dist[u] || l.wait(dist[u]) + l.travel_time) continue;
+
+				bool seen = false;
+				for (auto &g : group) seen = seen || g.v == l.from;
+				if (!seen) group.push({l.from, i, &l});
+			}
+		}
+
+		return v;
+	};
+
+	for (vertex v = target; !(v == source); ) {
+		vertex u = v;
+		switch (preds.get(v)) {
+			case step::none: return false;
+			case step::from_left: u.x--; break;
+			case step::from_right: u.x++; break;
+			case step::from_above: u.y--; break;
+			case step::from_below: u.y++; break;
+			case step::via_lift:
+				if (auto l = earlier_lift(v)) {
+					push_lift(*l);
+					v = l->from;
+				} else {
+					vertex w = leave_group(v);
+					if (w == v) return false;
+					v = w;
+				}
+				continue;
+		}
+
+		out.push({u, v, false, 0, dist[v], 1});
+		v = u;
+	}
+
+	for (int i = 0, j = out.size() - 1; i < j; i++, j--) {
+		path_step tmp = out[i];
+		out[i] = out[j];
+		out[j] = tmp;
+	}
+
+	return true;
+}
+
+// Binary dump of the distances from one source to every cell of a map, for
+// other tools to read. Like map_file, all fields are in the native byte
+// order.
+//
+//	header
+//	distances: width * height ints, row-major, INT_MAX for unreachable
+//	           cells
+namespace distance_file {
+
+constexpr char magic[8] = {'P', 'R', '2', 'D', 'I', 'S', 'T', '\n'};
+constexpr unsigned int version = 1;
+constexpr unsigned int byte_order = 0x01020304;
+
+struct header {
+	char magic[8];
+	unsigned int version;
+	unsigned int byte_order;
+
+	int width, height;
+	vertex source;
+};
+
+static_assert(sizeof(header) == 32, "the header layout is part of the format");
+
+// Runs a search from source to every cell of the map, and writes the
+// distances into the file at path. Prints what went wrong and returns
+// false on failure.
+inline bool dump(const map &m, vertex source, const char *path) {
+	search_state<radix_heap> state{m};
+	dijkstra_all(m, source, state);
+
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "%s: failed to open for writing\n", path);
+		return false;
+	}
+
+	header h{};
+	for (int i = 0; i < 8; i++) h.magic[i] = magic[i];
+	h.version = version;
+	h.byte_order = byte_order;
+	h.width = m.width;
+	h.height = m.height;
+	h.source = source;
+
+	output_writer out{fd};
+	out.write_bytes(&h, sizeof(h));
+
+	for (int y = 0; y < m.height; y++) {
+		for (int x = 0; x < m.width; x++) {
+			int d = state.dist[{x, y}];
+			out.write_bytes(&d, sizeof(d));
+		}
+	}
+
+	bool ok = out.flush();
+	if (close(fd) < 0) ok = false;
+
+	if (!ok) fprintf(stderr, "%s: failed to write\n", path);
+	return ok;
+}
+
+} // namespace distance_file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <linux/perf_event.h> // perf_event_attr, PERF_*
+#include <sys/ioctl.h>        // ioctl
+#include <sys/syscall.h>      // SYS_perf_event_open
+#include <unistd.h>           // syscall, read, close
+
+// Hardware cache counters of the calling thread, through perf_event_open.
+// Counters the kernel or the CPU doesn't provide (e.g. in containers or VMs
+// without a PMU) are simply unavailable, and read as -1.
+struct perf_counters {
+	enum counter {
+		cache_misses,
+		l1d_read_misses,
+		dtlb_read_misses,
+		n_counters,
+	};
+
+	static constexpr const char *names[n_counters] = {
+		"cache-misses",
+		"L1d-read-misses",
+		"dTLB-read-misses",
+	};
+
+	perf_counters() {
+		auto hw_cache = [] (unsigned long long cache) {
+			return cache
+				| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+				| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		};
+
+		fds_[cache_misses] = open_(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+		fds_[l1d_read_misses] = open_(PERF_TYPE_HW_CACHE, hw_cache(PERF_COUNT_HW_CACHE_L1D));
+		fds_[dtlb_read_misses] = open_(PERF_TYPE_HW_CACHE, hw_cache(PERF_COUNT_HW_CACHE_DTLB));
+	}
+
+	perf_counters(const perf_counters &other) = delete;
+	perf_counters(perf_counters &&other) = delete;
+	perf_counters &operator=(const perf_counters &other) = delete;
+	perf_counters &operator=(perf_counters &&other) = delete;
+
+	~perf_counters() {
+		for (int fd : fds_)
+			if (fd >= 0) close(fd);
+	}
+
+	bool available(counter c) const {
+		return fds_[c] >= 0;
+	}
+
+	void start() {
+		for (int fd : fds_) {
+			if (fd < 0) continue;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+
+	void stop() {
+		for (int fd : fds_)
+			if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+	}
+
+	long long read_counter(counter c) const {
+		long long value;
+		if (fds_[c] < 0 || read(fds_[c], &value, sizeof(value)) != sizeof(value))
+			return -1;
+		return value;
+	}
+
+private:
+	static int open_(unsigned int type, unsigned long long config) {
+		perf_event_attr attr{};
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+
+	int fds_[n_counters];
+};
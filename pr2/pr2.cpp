@@ -1,311 +1,563 @@
-#include <climits>
-#include <cstdio>
+#include <climits> // INT_MAX
+#include <cstdio>  // fprintf
+#include <cstdlib> // atoi, malloc, free
+#include <cstring> // strcmp
+#include <malloc.h> // malloc_usable_size
+#include <new>     // std::bad_alloc
+#include <unistd.h> // sysconf
+
+#include "../common/fast_io.hpp"
+#include "../common/timing.hpp"
+#include "astar.hpp"
+#include "batch.hpp"
+#include "bidirectional.hpp"
+#include "compact_graph.hpp"
+#include "containers.hpp"
+#include "delta_stepping.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "landmarks.hpp"
+#include "lean_map.hpp"
+#include "map.hpp"
+#include "map_file.hpp"
+#include "paths.hpp"
+#include "profile.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+#ifdef PR2_STATS
+// Every allocation goes through here for the peak_bytes statistic. The
+// input, if it's a file, is mapped rather than allocated, and isn't counted.
+void *operator new(std::size_t size) {
+	void *p = malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc{};
+
+	stats::allocated(malloc_usable_size(p));
+	return p;
+}
 
-struct vertex {
-	int x, y;
+void *operator new[](std::size_t size) {
+	return operator new(size);
+}
 
-	bool operator==(const vertex &other) const {
-		return other.x == x && other.y == y;
-	}
-};
+void operator delete(void *p) noexcept {
+	if (!p) return;
 
-struct neighbor {
-	vertex at;
-	int time;
-};
+	stats::freed(malloc_usable_size(p));
+	free(p);
+}
 
-struct lift {
-	vertex from;
-	vertex to;
+void operator delete[](void *p) noexcept {
+	operator delete(p);
+}
 
-	int leaves_every;
-	int travel_time;
-};
+void operator delete(void *p, std::size_t) noexcept {
+	operator delete(p);
+}
 
-// --------------------------------------------------------------------
+void operator delete[](void *p, std::size_t) noexcept {
+	operator delete(p);
+}
+#endif
 
-// Based on the description and pseudo-code from Wikipedia:
-// https://en.wikipedia.org/wiki/Pairing_heap
-struct pairing_heap {
-	pairing_heap() = default;
+namespace {
 
-	pairing_heap(const pairing_heap &other) = delete;
-	pairing_heap(pairing_heap &&other) = delete;
-	pairing_heap &operator=(const pairing_heap &other) = delete;
-	pairing_heap &operator=(pairing_heap &&other) = delete;
+input_reader in;
+output_writer out;
 
-	~pairing_heap() {
-		delete_tree_(root_);
-	}
+enum class solver {
+	dijkstra,
+	dial,
+	astar,
+	bidirectional,
+	alt,
+	delta_stepping,
+};
 
-private:
-	struct node {
-		node(int priority, vertex vtx)
-		: priority{priority}, vtx{vtx} { }
+struct options {
+	solver algorithm = solver::dijkstra;
+	bool print_settled = false;
+	bool serve_queries = false;
+	int n_threads = 0;
+	int delta = 16;
+	bool compact = false;
+	bool lean = false;
+	bool print_peak_rss = false;
+	const char *load_path = nullptr;
+	const char *save_path = nullptr;
+	int n_landmarks = 4;
+	const char *load_landmarks_path = nullptr;
+	const char *save_landmarks_path = nullptr;
+	bool print_path = false;
+	const char *dump_path = nullptr;
+	int first_departure = 0;
+	// Profile queries if set.
+	int n_departures = 0;
+	// Only with PR2_STATS.
+	bool print_stats = false;
+	bool stats_json = false;
+};
 
-		int priority;
-		vertex vtx;
+bool read_query(vertex &start, vertex &end) {
+	return in.read_int(start.x) && in.read_int(start.y)
+		&& in.read_int(end.x) && in.read_int(end.y);
+}
 
-		node *child = nullptr;
-		node *sibling = nullptr;
-	};
+template <typename Graph>
+bool in_bounds(const Graph &g, vertex v) {
+	return v.x >= 0 && v.x < g.width && v.y >= 0 && v.y < g.height;
+}
 
-public:
-	void insert(int priority, vertex vtx) {
-		root_ = meld_(root_, new node{priority, vtx});
-	}
+// Answers the query from the header, and with --queries, every following
+// "start.x start.y end.x end.y" line until the end of input. After each
+// answer, details() can print more about it.
+template <typename Graph, typename Route, typename Details>
+void answer_queries(const options &opts, const Graph &g, vertex start, vertex end,
+		Route route, Details details) {
+	do {
+		if (!in_bounds(g, start) || !in_bounds(g, end)) {
+			fprintf(stderr, "query (%d, %d) -> (%d, %d) is out of bounds\n",
+					start.x, start.y, end.x, end.y);
+			continue;
+		}
 
-	vertex extract_min() {
-		vertex vtx = root_->vtx;
+		search_result result;
+		{
+			stats::phase_timer timer{stats::search};
+			result = route(start, end);
+		}
 
-		auto old_root = root_;
-		root_ = merge_pairs_(root_->child);
-		delete old_root;
+		out.write_int(result.time);
+		out.write_char('\n');
+		details();
+		if (opts.print_settled)
+			fprintf(stderr, "settled %d vertices\n", result.settled);
 
-		return vtx;
-	}
+		if (opts.serve_queries) out.flush();
+	} while (opts.serve_queries && read_query(start, end));
+}
 
-	bool empty() const {
-		return !root_;
-	}
+template <typename Graph, typename Route>
+void answer_queries(const options &opts, const Graph &g, vertex start, vertex end, Route route) {
+	answer_queries(opts, g, start, end, route, [] { });
+}
 
-private:
-	static node *meld_(node *a, node *b) {
-		if (!a) return b;
-		else if (!b) return a;
+// With --threads, all queries are read up front and answered in parallel,
+// then printed in the input order.
+template <typename Queue, typename Graph, typename... Args>
+void answer_batch(const options &opts, const Graph &g, vertex start, vertex end, Args... queue_args) {
+	dynamic_vector<route_query> queries;
+
+	do {
+		if (!in_bounds(g, start) || !in_bounds(g, end)) {
+			fprintf(stderr, "query (%d, %d) -> (%d, %d) is out of bounds\n",
+					start.x, start.y, end.x, end.y);
+			continue;
+		}
 
-		if (a->priority < b->priority) {
-			b->sibling = a->child;
-			a->child = b;
+		queries.push({start, end});
+	} while (opts.serve_queries && read_query(start, end));
 
-			return a;
-		} else {
-			a->sibling = b->child;
-			b->child = a;
+	auto results = new search_result[queries.size()];
+	thread_pool pool{opts.n_threads};
+	{
+		stats::phase_timer timer{stats::search};
+		batch_route<Queue>(g, queries.begin(), results, queries.size(), pool, queue_args...);
+	}
 
-			return b;
-		}
+	for (int i = 0; i < queries.size(); i++) {
+		out.write_int(results[i].time);
+		out.write_char('\n');
+		if (opts.print_settled)
+			fprintf(stderr, "settled %d vertices\n", results[i].settled);
 	}
 
-	static node *merge_pairs_(node *list) {
-		if (!list) return nullptr;
-		if (!list->sibling) return list;
+	delete[] results;
+}
 
-		return meld_(meld_(list, list->sibling), merge_pairs_(list->sibling->sibling));
+template <typename Queue, typename Graph, typename... Args>
+void answer_with_router(const options &opts, const Graph &g, vertex start, vertex end, Args... queue_args) {
+	if (opts.n_threads) {
+		answer_batch<Queue>(opts, g, start, end, queue_args...);
+		return;
 	}
 
-	static void delete_tree_(node *at) {
-		if (!at) return;
-
-		auto child = at->child;
-		delete at;
+	stats::phase_timer init{stats::init};
+	router<Queue, Graph> r{g, queue_args...};
+	init.stop();
 
-		while (child) {
-			auto old = child;
-			child = child->sibling;
+	answer_queries(opts, g, start, end, [&] (vertex source, vertex target) {
+		return r.route(source, target);
+	});
+}
 
-			delete_tree_(old);
+// With --path, each answer is followed by the number of steps of the
+// route, and a "walk" or "lift" line per step:
+// kind from.x from.y to.x to.y wait arrival
+void answer_with_path(const options &opts, const map &m, vertex start, vertex end) {
+	stats::phase_timer init{stats::init};
+	search_state<pairing_heap> state{m};
+	predecessor_store preds{m.width, m.height};
+	dynamic_vector<path_step> path;
+	init.stop();
+
+	answer_queries(opts, m, start, end, [&] (vertex source, vertex target) {
+		auto result = shortest_path_tree(m, source, target, state, preds);
+		if (!reconstruct_path(m, state.dist, preds, source, target, path))
+			path.clear();
+
+		return result;
+	}, [&] {
+		out.write_int(path.size());
+		out.write_char('\n');
+
+		for (auto s : path) {
+			int fields[] = {s.from.x, s.from.y, s.to.x, s.to.y, s.wait, s.arrival};
+
+			out.write_str(s.lift ? "lift" : "walk");
+			for (int f : fields) {
+				out.write_char(' ');
+				out.write_int(f);
+			}
+			out.write_char('\n');
 		}
-	}
+	});
+}
 
-	node *root_ = nullptr;
-};
+// With --profile FIRST COUNT, each answer is the travel time departing at
+// FIRST, followed by a line with the travel times departing at FIRST,
+// FIRST + 1, ..., FIRST + COUNT - 1.
+void answer_with_profile(const options &opts, const map &m, vertex start, vertex end) {
+	stats::phase_timer init{stats::init};
+	profile_router<> r{m};
+	int *arrivals = new int[opts.n_departures];
+	init.stop();
+
+	answer_queries(opts, m, start, end, [&] (vertex source, vertex target) {
+		auto result = r.route(source, target, opts.first_departure, opts.n_departures, arrivals);
+		int settled = result.settled < INT_MAX ? result.settled : INT_MAX;
+
+		return search_result{arrivals[0] - opts.first_departure, settled};
+	}, [&] {
+		for (int i = 0; i < opts.n_departures; i++) {
+			if (i) out.write_char(' ');
+			out.write_int(arrivals[i] - opts.first_departure - i);
+		}
+		out.write_char('\n');
+	});
 
-template <typename T>
-struct array2d {
-	array2d(int width, int height)
-	: width{width}, height{height}
-	, data{new T[width * height]{}} { }
-
-	array2d(const array2d &other) = delete;
-	array2d(array2d &&other) = delete;
-	array2d &operator=(const array2d &other) = delete;
-	array2d &operator=(array2d &&other) = delete;
-
-	~array2d() {
-		delete[] data;
-	}
+	delete[] arrivals;
+}
 
-	T &operator[](vertex vtx) const {
-		return data[vtx.x + width * vtx.y];
-	}
+template <typename Graph>
+void answer_with_dijkstra(const options &opts, const Graph &g, vertex start, vertex end) {
+	// Without lifts, and with every grid edge taking one unit, vertices
+	// are queued in the order of their distance, and no priority is ever
+	// lowered.
+	if (opts.algorithm == solver::dijkstra && !g.n_lifts && g.max_edge() <= 1)
+		answer_with_router<pairing_heap>(opts, g, start, end);
+	else if (opts.algorithm == solver::dijkstra)
+		answer_with_router<indexed_pairing_heap>(opts, g, start, end);
+	// Same choice of queue as dial().
+	else if (g.max_edge() < dial_max_buckets)
+		answer_with_router<bucket_queue>(opts, g, start, end, g.max_edge());
+	else
+		answer_with_router<radix_heap>(opts, g, start, end);
+}
 
-	const int width, height;
-	T *const data;
-};
+// With --delta-stepping, each query is searched by all --threads threads
+// together, or as many as there are CPUs.
+template <typename Graph>
+void answer_with_delta_stepping(const options &opts, const Graph &g, vertex start, vertex end) {
+	int n_threads = opts.n_threads;
+	if (!n_threads) n_threads = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+
+	stats::phase_timer init{stats::init};
+	thread_pool pool{n_threads};
+	delta_stepping_router<Graph> r{g, pool, opts.delta};
+	init.stop();
+
+	answer_queries(opts, g, start, end, [&] (vertex source, vertex target) {
+		return r.route(source, target);
+	});
+}
 
+// With --lean, the map is read into lean_map instead, for maps that don't
+// fit into memory otherwise.
 template <typename T>
-struct fixed_vector {
-	explicit fixed_vector(int capacity)
-	: capacity_{capacity}, data_{new T[capacity]} { }
-
-	fixed_vector(const fixed_vector &other) = delete;
-	fixed_vector(fixed_vector &&other) = delete;
-	fixed_vector &operator=(const fixed_vector &other) = delete;
-	fixed_vector &operator=(fixed_vector &&other) = delete;
+void answer_lean(const options &opts, const narrow_heights &heights, const sparse_lifts &lifts,
+		vertex start, vertex end) {
+	stats::phase_timer init{stats::init};
+	lean_map<T> m{heights, lifts};
+	lean_router<T> r{m};
+	init.stop();
+
+	answer_queries(opts, m, start, end, [&] (vertex source, vertex target) {
+		return r.route(source, target);
+	});
+}
 
-	~fixed_vector() {
-		delete[] data_;
-	}
+bool run_lean(const options &opts, const map_header &header) {
+	sparse_lifts lifts{header.width, header.height, header.n_lifts};
+	narrow_heights heights{header.width, header.height};
 
-	int size() const {
-		return size_;
-	}
+	stats::phase_timer lifts_timer{stats::read_lifts};
+	bool ok = lifts.read(in);
+	lifts_timer.stop();
 
-	void push(const T &t) {
-		data_[size_++] = t;
-	}
+	stats::phase_timer heights_timer{stats::read_heights};
+	ok = ok && heights.read(in);
+	heights_timer.stop();
 
-	void clear() {
-		size_ = 0;
+	if (!ok) {
+		fprintf(stderr, "malformed map, or not enough memory for it\n");
+		return false;
 	}
 
-	T *begin() const {
-		return data_;
-	}
-
-	T *end() const {
-		return data_ + size_;
-	}
-
-private:
-	const int capacity_;
-	int size_ = 0;
-	T *const data_;
-};
-
-// --------------------------------------------------------------------
+	if (heights.bytes == 1)
+		answer_lean<unsigned char>(opts, heights, lifts, header.start, header.end);
+	else if (heights.bytes == 2)
+		answer_lean<unsigned short>(opts, heights, lifts, header.start, header.end);
+	else
+		answer_lean<unsigned int>(opts, heights, lifts, header.start, header.end);
 
-struct map {
-	map(int width, int height, int n_lifts)
-	: width{width}, height{height}, n_lifts{n_lifts}
-	, heights{width, height}, lifts{width, height}
-	, neighbors_{4 + n_lifts} { }
-
-	map(const map &other) = delete;
-	map(map &&other) = delete;
-
-	map &operator=(const map &other) = delete;
-	map &operator=(map &&other) = delete;
-
-	~map() {
-		for (int i = 0; i < width * height; i++)
-			delete lifts.data[i];
-	}
-
-	void read_lifts() {
-		for (int i = 0; i < n_lifts; i++) {
-			lift l;
-			scanf("%d%d%d%d%d%d",
-					&l.from.x, &l.from.y,
-					&l.to.x, &l.to.y,
-					&l.travel_time,
-					&l.leaves_every);
+	return true;
+}
 
-			auto &vec = lifts[l.from];
-			if (!vec) vec = new fixed_vector<lift>{n_lifts};
+} // namespace anonymous
+
+int main(int argc, char **argv) {
+	options opts;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--dial")) {
+			opts.algorithm = solver::dial;
+		} else if (!strcmp(argv[i], "--astar")) {
+			opts.algorithm = solver::astar;
+		} else if (!strcmp(argv[i], "--bidirectional")) {
+			opts.algorithm = solver::bidirectional;
+		} else if (!strcmp(argv[i], "--alt")) {
+			opts.algorithm = solver::alt;
+		} else if (!strcmp(argv[i], "--delta-stepping")) {
+			opts.algorithm = solver::delta_stepping;
+		} else if (!strcmp(argv[i], "--delta") && i + 1 < argc) {
+			opts.delta = atoi(argv[++i]);
+			if (opts.delta < 1) opts.delta = 1;
+		} else if (!strcmp(argv[i], "--landmarks") && i + 1 < argc) {
+			opts.n_landmarks = atoi(argv[++i]);
+			if (opts.n_landmarks < 1) opts.n_landmarks = 1;
+		} else if (!strcmp(argv[i], "--load-landmarks") && i + 1 < argc) {
+			opts.algorithm = solver::alt;
+			opts.load_landmarks_path = argv[++i];
+		} else if (!strcmp(argv[i], "--save-landmarks") && i + 1 < argc) {
+			opts.save_landmarks_path = argv[++i];
+		} else if (!strcmp(argv[i], "--path")) {
+			opts.print_path = true;
+		} else if (!strcmp(argv[i], "--profile") && i + 2 < argc) {
+			opts.first_departure = atoi(argv[++i]);
+			opts.n_departures = atoi(argv[++i]);
+			if (opts.first_departure < 0 || opts.n_departures < 1) {
+				fprintf(stderr, "--profile needs a departure of at least 0 and at least 1 departure\n");
+				return 1;
+			}
+		} else if (!strcmp(argv[i], "--dump-distances") && i + 1 < argc) {
+			opts.dump_path = argv[++i];
+		} else if (!strcmp(argv[i], "--stats") || !strcmp(argv[i], "--stats-json")) {
+			if (!stats::enabled) {
+				fprintf(stderr, "%s: built without statistics, configure with -Dstats=true\n", argv[i]);
+				return 1;
+			}
 
-			vec->push(l);
+			opts.print_stats = true;
+			opts.stats_json = !strcmp(argv[i], "--stats-json");
+		} else if (!strcmp(argv[i], "--settled")) {
+			opts.print_settled = true;
+		} else if (!strcmp(argv[i], "--queries")) {
+			opts.serve_queries = true;
+		} else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+			opts.n_threads = atoi(argv[++i]);
+			if (opts.n_threads < 1) opts.n_threads = 1;
+		} else if (!strcmp(argv[i], "--compact")) {
+			opts.compact = true;
+		} else if (!strcmp(argv[i], "--lean")) {
+			opts.lean = true;
+		} else if (!strcmp(argv[i], "--peak-rss")) {
+			opts.print_peak_rss = true;
+		} else if (!strcmp(argv[i], "--load-binary") && i + 1 < argc) {
+			opts.load_path = argv[++i];
+		} else if (!strcmp(argv[i], "--save-binary") && i + 1 < argc) {
+			opts.save_path = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [--dial | --astar | --bidirectional | --alt | --delta-stepping [--delta N]]"
+					" [--settled]"
+					" [--compact | --lean] [--queries] [--threads N]"
+					" [--load-binary FILE | --save-binary FILE]"
+					" [--landmarks N] [--load-landmarks FILE | --save-landmarks FILE]"
+					" [--path | --profile FIRST COUNT | --dump-distances FILE]"
+					" [--stats | --stats-json] [--peak-rss]\n", argv[0]);
+			return 1;
 		}
 	}
 
-	void read_heights() {
-		for (int i = 0; i < width * height; i++)
-			scanf("%d", heights.data + i);
+	if ((opts.n_threads || opts.compact) && (opts.algorithm == solver::astar
+				|| opts.algorithm == solver::bidirectional || opts.algorithm == solver::alt)) {
+		fprintf(stderr, "--threads and --compact only work with Dijkstra's and Dial's algorithms,"
+				" and delta-stepping\n");
+		return 1;
 	}
 
-	auto &compute_neighbors(int time, vertex from)  {
-		int B = heights[from];
-		neighbors_.clear();
+	if (opts.print_path && (opts.n_threads || opts.compact || opts.algorithm != solver::dijkstra)) {
+		fprintf(stderr, "--path only works with plain Dijkstra's algorithm\n");
+		return 1;
+	}
 
-		auto insert_grid_edge = [&] (vertex to) {
-			if (to.x < 0 || to.x >= width) return;
-			if (to.y < 0 || to.y >= height) return;
-			int A = heights[to];
+	if (opts.n_departures && (opts.print_path || opts.n_threads || opts.compact
+				|| opts.algorithm != solver::dijkstra)) {
+		fprintf(stderr, "--profile only works with plain Dijkstra's algorithm\n");
+		return 1;
+	}
 
-			neighbors_.push({to, A > B ? A - B + 1 : 1});
-		};
+	if (opts.lean && (opts.n_threads || opts.compact || opts.load_path || opts.save_path
+				|| opts.save_landmarks_path || opts.print_path || opts.n_departures
+				|| opts.dump_path || opts.algorithm != solver::dijkstra)) {
+		fprintf(stderr, "--lean only works with plain Dijkstra's algorithm on a text map\n");
+		return 1;
+	}
 
-		auto insert_lift_edge = [&] (lift l) {
-			int last_departure = time % l.leaves_every;
-			int next_departure = last_departure ? l.leaves_every - last_departure : 0;
+	map_header header;
+	map *loaded;
 
-			neighbors_.push({l.to, next_departure + l.travel_time});
-		};
+	if (opts.lean) {
+		if (!header.read(in)) {
+			fprintf(stderr, "missing or malformed map header\n");
+			return 1;
+		}
 
-		insert_grid_edge({from.x - 1, from.y});
-		insert_grid_edge({from.x + 1, from.y});
-		insert_grid_edge({from.x, from.y - 1});
-		insert_grid_edge({from.x, from.y + 1});
+		if (!run_lean(opts, header)) return 1;
 
-		if (lifts[from]) {
-			for (auto lift : *lifts[from]) insert_lift_edge(lift);
+		out.flush();
+		if (opts.print_peak_rss)
+			fprintf(stderr, "peak RSS %.1f MiB\n", peak_rss_bytes() / 1048576.0);
+		if (opts.print_stats) {
+			stats::flush_thread();
+			stats::report(opts.stats_json);
 		}
-
-		return neighbors_;
+		return 0;
 	}
 
-	const int width, height;
-	const int n_lifts;
-	array2d<int> heights;
-	array2d<fixed_vector<lift> *> lifts;
-
-private:
-	fixed_vector<neighbor> neighbors_;
-};
+	if (opts.load_path) {
+		// Only the map comes from the file, further queries with
+		// --queries are still read from stdin.
+		// Mostly the heights, and there's no separate step for the lifts.
+		stats::phase_timer timer{stats::read_heights};
+		loaded = map_file::load(opts.load_path, header);
+		if (!loaded) return 1;
+	} else {
+		if (!header.read(in)) {
+			fprintf(stderr, "missing or malformed map header\n");
+			return 1;
+		}
 
-// --------------------------------------------------------------------
+		loaded = new map{header.width, header.height, header.n_lifts};
+		stats::phase_timer lifts_timer{stats::read_lifts};
+		loaded->read_lifts(in);
+		lifts_timer.stop();
 
-// Based on the description and pseudo-code from Wikipedia:
-// https://en.wikipedia.org/wiki/Dijkstra's_algorithm#Using_a_priority_queue
-// Implements the variant where only source is added to the queue, and
-// new elements are added in place of Q.decrease_priority.
-int dijkstra(map &m, vertex source, vertex target) {
-	array2d<int> dist{m.width, m.height};
-	pairing_heap Q;
+		stats::phase_timer heights_timer{stats::read_heights};
+		loaded->read_heights(in);
+	}
 
-	Q.insert(0, source);
+	map &m = *loaded;
+	vertex start = header.start, end = header.end;
 
-	for (int y = 0; y < m.height; y++) {
-		for (int x = 0; x < m.width; x++) {
-			vertex v{x, y};
-			dist[v] = v == source ? 0 : INT_MAX;
-		}
+	if (opts.save_path) {
+		bool ok = map_file::save(m, header, opts.save_path);
+		delete loaded;
+		return ok ? 0 : 1;
 	}
 
-	while (!Q.empty()) {
-		auto u = Q.extract_min();
-		if (u == target) break;
-
-		for (auto [v, edge] : m.compute_neighbors(dist[u], u)) {
-			auto alt = dist[u] + edge;
+	if (opts.dump_path) {
+		bool ok = distance_file::dump(m, start, opts.dump_path);
+		delete loaded;
+		return ok ? 0 : 1;
+	}
 
-			if (alt < dist[v]) {
-				dist[v] = alt;
-				Q.insert(alt, v);
-			}
-		}
+	if (opts.save_landmarks_path) {
+		landmarks l{m, opts.n_landmarks};
+		bool ok = landmark_file::save(l, opts.save_landmarks_path);
+		delete loaded;
+		return ok ? 0 : 1;
 	}
 
-	return dist[target];
-}
+	switch (opts.algorithm) {
+		case solver::dijkstra:
+		case solver::dial:
+			if (opts.print_path) {
+				answer_with_path(opts, m, start, end);
+			} else if (opts.n_departures) {
+				answer_with_profile(opts, m, start, end);
+			} else if (opts.compact && compact_graph::fits(m)) {
+				stats::phase_timer init{stats::init};
+				compact_graph g{m};
+				init.stop();
+
+				answer_with_dijkstra(opts, g, start, end);
+			} else {
+				answer_with_dijkstra(opts, m, start, end);
+			}
+			break;
+		case solver::delta_stepping:
+			if (opts.compact && compact_graph::fits(m)) {
+				stats::phase_timer init{stats::init};
+				compact_graph g{m};
+				init.stop();
+
+				answer_with_delta_stepping(opts, g, start, end);
+			} else {
+				answer_with_delta_stepping(opts, m, start, end);
+			}
+			break;
+		case solver::astar:
+			answer_queries(opts, m, start, end, [&] (vertex source, vertex target) {
+				return astar<lift_heuristic>(m, source, target);
+			});
+			break;
+		case solver::bidirectional:
+			answer_queries(opts, m, start, end, [&] (vertex source, vertex target) {
+				return bidirectional(m, source, target);
+			});
+			break;
+		case solver::alt: {
+			stats::phase_timer init{stats::init};
+			auto l = opts.load_landmarks_path
+				? landmark_file::load(opts.load_landmarks_path, m)
+				: new landmarks{m, opts.n_landmarks};
+			init.stop();
+
+			if (!l) {
+				delete loaded;
+				return 1;
+			}
 
-// --------------------------------------------------------------------
+			alt_router<> r{m, *l};
+			answer_queries(opts, m, start, end, [&] (vertex source, vertex target) {
+				return r.route(source, target);
+			});
 
-int main() {
-	int width, height;
-	vertex start, end;
-	int n_lifts;
+			delete l;
+			break;
+		}
+	}
 
-	scanf("%d%d%d%d%d%d%d",
-			&width, &height,
-			&start.x, &start.y,
-			&end.x, &end.y,
-			&n_lifts);
+	delete loaded;
+	out.flush();
 
-	map m{width, height, n_lifts};
-	m.read_lifts();
-	m.read_heights();
+	if (opts.print_peak_rss)
+		fprintf(stderr, "peak RSS %.1f MiB\n", peak_rss_bytes() / 1048576.0);
 
-	printf("%d\n", dijkstra(m, start, end));
+	if (opts.print_stats) {
+		stats::flush_thread();
+		stats::report(opts.stats_json);
+	}
 }
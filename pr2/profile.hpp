@@ -0,0 +1,210 @@
+#pragma once
+
+#include "containers.hpp"
+#include "dijkstra.hpp"
+#include "heap.hpp"
+#include "landmarks.hpp"
+#include "map.hpp"
+#include "paths.hpp"
+#include "types.hpp"
+
+// Profile queries: the arrival time at a target for every departure time
+// from the source within a window, without a search per departure.
+//
+// Leaving later never gets anyone anywhere sooner, since the wait for a
+// lift only depends on when someone gets there. So with the routes found
+// for departures lo and hi, every departure t in between arrives
+//	no sooner than max(arrival(s), t + d), for any s <= t already known
+//	no later than  min(route_lo(t), route_hi(t))
+// where d is the distance with every wait dropped (lower_bound_graph), and
+// route(t) is when following a route departing at t arrives. Wherever the
+// two bounds meet, that's the arrival time. Wherever they don't, the window
+// is split at another search, until every departure is known.
+//
+// On top of that, the waits repeat every lcm of the lift periods, so a
+// departure that much later than another one arrives that much later too,
+// and only the departures within the first period need working out.
+
+// Least common multiple of the periods of all lifts, or limit if that's
+// smaller.
+inline int schedule_period(const map &m, int limit) {
+	long long period = 1;
+
+	for (auto &l : m.all_lifts()) {
+		long long a = period, b = l.leaves_every;
+		while (b) {
+			long long r = a % b;
+			a = b;
+			b = r;
+		}
+
+		period = period / a * l.leaves_every;
+		if (period >= limit) return limit;
+	}
+
+	return period;
+}
+
+struct profile_result {
+	// Full searches run, counting the one on the lower_bound_graph.
+	int searches;
+	long long settled;
+};
+
+// Answers many profile queries on the same map, keeping the search state
+// around between them.
+template <typename Queue = radix_heap>
+struct profile_router {
+	explicit profile_router(const map &m)
+	: m_{m}, bounds_{m}, state_{m}, bound_state_{bounds_}
+	, preds_{m.width, m.height} { }
+
+	profile_router(const profile_router &other) = delete;
+	profile_router(profile_router &&other) = delete;
+	profile_router &operator=(const profile_router &other) = delete;
+	profile_router &operator=(profile_router &&other) = delete;
+
+	// Fills arrivals[i] with the arrival time at target when leaving source
+	// at first_departure + i, for each of the n_departures departures.
+	// Departures must not be negative.
+	profile_result route(vertex source, vertex target, int first_departure,
+			int n_departures, int *arrivals) {
+		profile_result result{0, 0};
+		if (n_departures < 1) return result;
+
+		int period = schedule_period(m_, n_departures);
+		routes_.clear();
+		legs_.clear();
+		route_of_.clear();
+		for (int i = 0; i < period; i++) route_of_.push(-1);
+
+		auto search = [&] (int i) {
+			int departure = first_departure + i;
+			auto r = shortest_path_tree(m_, source, target, state_, preds_, departure);
+			reconstruct_path(m_, state_.dist, preds_, source, target, steps_);
+
+			arrivals[i] = departure + r.time;
+			route_of_[i] = add_route_(departure);
+			result.searches++;
+			result.settled += r.settled;
+		};
+
+		search(0);
+		if (period > 1) search(period - 1);
+
+		if (period > 2) {
+			auto r = dijkstra(bounds_, source, target, bound_state_);
+			int no_waits = r.time;
+			result.searches++;
+			result.settled += r.settled;
+
+			intervals_.clear();
+			intervals_.push({0, period - 1});
+
+			while (!intervals_.empty()) {
+				auto [lo, hi] = intervals_.pop();
+				int split = -1;
+				// The latest arrival known so far, no later departure
+				// arrives sooner.
+				int floor = arrivals[lo];
+
+				for (int i = lo + 1; i < hi; i++) {
+					if (route_of_[i] >= 0) {
+						floor = arrivals[i];
+						continue;
+					}
+
+					int t = first_departure + i;
+					int via_lo = follow_(route_of_[lo], t), via_hi = follow_(route_of_[hi], t);
+					int upper = via_lo < via_hi ? via_lo : via_hi;
+					int lower = floor > t + no_waits ? floor : t + no_waits;
+
+					if (upper == lower) {
+						arrivals[i] = upper;
+						route_of_[i] = via_lo < via_hi ? route_of_[lo] : route_of_[hi];
+					} else if (split < 0 || distance_(i, lo, hi) < distance_(split, lo, hi)) {
+						split = i;
+					}
+				}
+
+				if (split < 0) continue;
+
+				search(split);
+				intervals_.push({lo, split});
+				intervals_.push({split, hi});
+			}
+		}
+
+		for (int i = period; i < n_departures; i++)
+			arrivals[i] = arrivals[i - period] + period;
+
+		return result;
+	}
+
+private:
+	// Walk, then wait for a lift and take it. A route is a list of legs,
+	// ending with one with a lift that leaves every 1 and takes 0.
+	struct leg {
+		int walk;
+		int leaves_every;
+		int travel;
+	};
+
+	struct interval {
+		int lo, hi;
+	};
+
+	// Twice the distance of i from the middle of [lo, hi].
+	static int distance_(int i, int lo, int hi) {
+		int d = 2 * i - lo - hi;
+		return d < 0 ? -d : d;
+	}
+
+	// Adds the route in steps_, which departed at the given time.
+	int add_route_(int departure) {
+		routes_.push(legs_.size());
+
+		int time = departure, walk = 0;
+		for (auto &s : steps_) {
+			if (s.lift) {
+				legs_.push({walk, s.leaves_every, s.arrival - time - s.wait});
+				walk = 0;
+			} else {
+				walk += s.arrival - time;
+			}
+			time = s.arrival;
+		}
+		legs_.push({walk, 1, 0});
+
+		return routes_.size() - 1;
+	}
+
+	// When following a route departing at the given time arrives.
+	int follow_(int route, int time) const {
+		int end = route + 1 < routes_.size() ? routes_[route + 1] : legs_.size();
+
+		for (int i = routes_[route]; i < end; i++) {
+			auto &l = legs_[i];
+			time += l.walk;
+
+			time += lift::wait(l.leaves_every, time) + l.travel;
+		}
+
+		return time;
+	}
+
+	const map &m_;
+	lower_bound_graph bounds_;
+	search_state<Queue> state_;
+	search_state<Queue> bound_state_;
+	predecessor_store preds_;
+
+	dynamic_vector<path_step> steps_;
+	// Where the legs of each route start.
+	dynamic_vector<int> routes_;
+	dynamic_vector<leg> legs_;
+	// The route that arrives the soonest for each departure, or -1 if that
+	// isn't known yet.
+	dynamic_vector<int> route_of_;
+	dynamic_vector<interval> intervals_;
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdio> // fprintf
+
+#include "../common/timing.hpp"
+
+// Counters for what the searches spend their time on, only compiled in with
+// PR2_STATS defined (meson configure -Dstats=true). Without it, every hook
+// below is empty and compiles away, so the searches can call them
+// unconditionally.
+//
+// Counts are kept per thread, so concurrent searches don't contend on
+// them, and added up by flush_thread() once a thread is done searching.
+namespace stats {
+
+#ifdef PR2_STATS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+struct counters {
+	long long pushes;
+	long long pops;
+	// Outdated duplicate entries, left behind by inserting again instead
+	// of decreasing the priority.
+	long long stale_pops;
+	// Queued vertices reached sooner, whose priority was lowered in place
+	// rather than inserting them again.
+	long long decreases;
+	// Edges looked at, whether they improved anything or not.
+	long long relaxations;
+	long long lift_edges;
+
+	long long queue_size;
+	long long peak_queue;
+};
+
+enum phase {
+	read_lifts,
+	read_heights,
+	init,
+	search,
+	n_phases,
+};
+
+constexpr const char *phase_names[n_phases] = {
+	"read_lifts",
+	"read_heights",
+	"init",
+	"search",
+};
+
+inline thread_local counters local;
+inline counters total;
+inline long long phase_ns[n_phases];
+
+// Kept up to date by the allocation functions of the program, if it
+// replaces them (pr2 does).
+inline long long allocated_bytes;
+inline long long peak_bytes;
+
+inline void pushed(int entries = 1) {
+	if constexpr (enabled) {
+		local.pushes += entries;
+		local.queue_size += entries;
+		if (local.queue_size > local.peak_queue)
+			local.peak_queue = local.queue_size;
+	}
+}
+
+inline void decreased(int entries = 1) {
+	if constexpr (enabled)
+		local.decreases += entries;
+}
+
+// With what a queue's insert() returned.
+inline void inserted(bool added) {
+	if (added) pushed();
+	else decreased();
+}
+
+inline void popped(bool stale) {
+	if constexpr (enabled) {
+		local.pops++;
+		local.stale_pops += stale;
+		local.queue_size--;
+	}
+}
+
+// Searches clear the queue when they start, or stop with entries left in it.
+inline void queue_cleared() {
+	if constexpr (enabled)
+		local.queue_size = 0;
+}
+
+inline void relaxed(int edges) {
+	if constexpr (enabled)
+		local.relaxations += edges;
+}
+
+inline void lift_edges(int edges) {
+	if constexpr (enabled)
+		local.lift_edges += edges;
+}
+
+inline void allocated(long long bytes) {
+	if constexpr (enabled) {
+		long long now = __atomic_add_fetch(&allocated_bytes, bytes, __ATOMIC_RELAXED);
+		long long peak = __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);
+		while (now > peak && !__atomic_compare_exchange_n(&peak_bytes, &peak, now,
+					true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			;
+	}
+}
+
+inline void freed(long long bytes) {
+	if constexpr (enabled)
+		__atomic_sub_fetch(&allocated_bytes, bytes, __ATOMIC_RELAXED);
+}
+
+// Adds the counts of the calling thread to the total, and resets them.
+inline void flush_thread() {
+	if constexpr (enabled) {
+		__atomic_add_fetch(&total.pushes, local.pushes, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&total.pops, local.pops, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&total.stale_pops, local.stale_pops, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&total.decreases, local.decreases, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&total.relaxations, local.relaxations, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&total.lift_edges, local.lift_edges, __ATOMIC_RELAXED);
+
+		long long peak = __atomic_load_n(&total.peak_queue, __ATOMIC_RELAXED);
+		while (local.peak_queue > peak && !__atomic_compare_exchange_n(&total.peak_queue,
+					&peak, local.peak_queue, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			;
+
+		local = {};
+	}
+}
+
+// Adds the wall time between its construction and destruction (or stop())
+// to a phase.
+struct phase_timer {
+	explicit phase_timer(phase p)
+	: phase_{p} {
+		if constexpr (enabled) start_ = now_ns();
+	}
+
+	phase_timer(const phase_timer &other) = delete;
+	phase_timer(phase_timer &&other) = delete;
+	phase_timer &operator=(const phase_timer &other) = delete;
+	phase_timer &operator=(phase_timer &&other) = delete;
+
+	~phase_timer() {
+		stop();
+	}
+
+	void stop() {
+		if constexpr (enabled) {
+			if (stopped_) return;
+
+			phase_ns[phase_] += now_ns() - start_;
+			stopped_ = true;
+		}
+	}
+
+private:
+	phase phase_;
+	long long start_ = 0;
+	bool stopped_ = false;
+};
+
+// Prints the totals to stderr, either as text or as a JSON object. Only
+// counts flushed with flush_thread() are included.
+inline void report(bool json) {
+	struct {
+		const char *name;
+		long long value;
+	} fields[] = {
+		{"pushes", total.pushes},
+		{"pops", total.pops},
+		{"stale_pops", total.stale_pops},
+		{"decreases", total.decreases},
+		{"relaxations", total.relaxations},
+		{"lift_edges", total.lift_edges},
+		{"peak_queue", total.peak_queue},
+		{"peak_bytes", peak_bytes},
+	};
+
+	if (json) {
+		fprintf(stderr, "{");
+		for (auto [name, value] : fields)
+			fprintf(stderr, "\"%s\": %lld, ", name, value);
+
+		fprintf(stderr, "\"phases_ms\": {");
+		for (int i = 0; i < n_phases; i++)
+			fprintf(stderr, "%s\"%s\": %.3f", i ? ", " : "", phase_names[i], phase_ns[i] / 1e6);
+		fprintf(stderr, "}}\n");
+	} else {
+		for (auto [name, value] : fields)
+			fprintf(stderr, "%-14s %14lld\n", name, value);
+		for (int i = 0; i < n_phases; i++)
+			fprintf(stderr, "%-14s %14.3f ms\n", phase_names[i], phase_ns[i] / 1e6);
+	}
+}
+
+} // namespace stats
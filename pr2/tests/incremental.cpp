@@ -0,0 +1,105 @@
+#include <cstdio> // printf
+
+#include "../incremental.hpp"
+
+// Checks incremental_router against searching again with dijkstra(), on
+// small random maps with lifts (self loops included) edited at random
+// between queries. Exits with 1 on the first wrong answer.
+
+namespace {
+
+struct lcg {
+	unsigned long long state;
+
+	int next(int bound) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<int>((state >> 33) % bound);
+	}
+};
+
+bool check(incremental_router &ir, map &m, vertex source, vertex target, const char *what) {
+	int got = ir.route(source, target).time;
+	int expected = dijkstra(m, source, target).time;
+	if (got == expected) return true;
+
+	printf("%s: (%d, %d) -> (%d, %d) took %d, expected %d\n", what,
+			source.x, source.y, target.x, target.y, got, expected);
+	return false;
+}
+
+// A lift that leaves every unit and takes no time back to where it leaves
+// from used to keep a stale rhs of its cell up after the cell before it
+// was lowered again.
+bool self_loop() {
+	map m{2, 1, 1};
+	m.heights[{0, 0}] = 7;
+	m.heights[{1, 0}] = 8;
+	m.add_lift({{1, 0}, {1, 0}, 1, 0});
+	m.index_lifts();
+
+	incremental_router ir{m};
+	ir.route({0, 0}, {1, 0});
+	ir.set_height({0, 0}, 17);
+	ir.route({0, 0}, {0, 0});
+	ir.set_height({0, 0}, 6);
+	return check(ir, m, {0, 0}, {1, 0}, "self loop");
+}
+
+bool random_edits(int seed) {
+	lcg rng{static_cast<unsigned long long>(seed)};
+	int width = 1 + rng.next(5), height = 1 + rng.next(5);
+	int n_lifts = rng.next(6);
+
+	auto random_vertex = [&] { return vertex{rng.next(width), rng.next(height)}; };
+	auto random_lift = [&] {
+		vertex from = random_vertex();
+		vertex to = rng.next(4) ? random_vertex() : from;
+		return lift{from, to, 1 + rng.next(4), rng.next(5)};
+	};
+
+	map m{width, height, n_lifts};
+	for (int i = 0; i < width * height; i++)
+		m.heights.data[i] = rng.next(20);
+	for (int i = 0; i < n_lifts; i++)
+		m.add_lift(random_lift());
+	m.index_lifts();
+
+	incremental_router ir{m};
+	vertex source = random_vertex();
+
+	for (int step = 0; step < 20; step++) {
+		int edit = rng.next(4);
+
+		if (edit <= 1) {
+			vertex v = random_vertex();
+			ir.set_height(v, rng.next(20));
+		} else if (edit == 2) {
+			ir.insert_lift(random_lift());
+		} else if (m.all_lifts().size()) {
+			// A copy, since removing it moves the map's lifts.
+			auto lifts = m.all_lifts();
+			lift l = lifts.first[rng.next(lifts.size())];
+			ir.remove_lift(l);
+		}
+
+		vertex target = random_vertex();
+		if (!check(ir, m, source, target, "random edits")) {
+			printf("seed %d, step %d\n", seed, step);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace anonymous
+
+int main() {
+	if (!self_loop()) return 1;
+
+	for (int seed = 0; seed < 3000; seed++) {
+		if (!random_edits(seed)) return 1;
+	}
+
+	printf("ok\n");
+}
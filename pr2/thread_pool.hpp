@@ -0,0 +1,151 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h> // sched_yield
+
+// A fixed set of threads that all run the same job together. The calling
+// thread takes part as thread 0, so a pool of size 1 spawns no threads.
+struct thread_pool {
+	explicit thread_pool(int n_threads)
+	: n_threads_{n_threads < 1 ? 1 : n_threads}
+	, workers_{new worker[n_threads_ - 1]} {
+		pthread_mutex_init(&mutex_, nullptr);
+		pthread_cond_init(&start_, nullptr);
+		pthread_cond_init(&done_, nullptr);
+
+		for (int i = 0; i < n_threads_ - 1; i++) {
+			workers_[i] = {this, i + 1, {}};
+			pthread_create(&workers_[i].thread, nullptr, worker_main_, &workers_[i]);
+		}
+	}
+
+	thread_pool(const thread_pool &other) = delete;
+	thread_pool(thread_pool &&other) = delete;
+	thread_pool &operator=(const thread_pool &other) = delete;
+	thread_pool &operator=(thread_pool &&other) = delete;
+
+	~thread_pool() {
+		pthread_mutex_lock(&mutex_);
+		shutdown_ = true;
+		pthread_cond_broadcast(&start_);
+		pthread_mutex_unlock(&mutex_);
+
+		for (int i = 0; i < n_threads_ - 1; i++)
+			pthread_join(workers_[i].thread, nullptr);
+
+		delete[] workers_;
+		pthread_cond_destroy(&done_);
+		pthread_cond_destroy(&start_);
+		pthread_mutex_destroy(&mutex_);
+	}
+
+	int size() const {
+		return n_threads_;
+	}
+
+	// Calls job(thread_index) on every thread of the pool, and returns
+	// once all of them have returned.
+	template <typename F>
+	void run(F &job) {
+		pthread_mutex_lock(&mutex_);
+		job_ = [] (void *ctx, int index) { (*static_cast<F *>(ctx))(index); };
+		ctx_ = &job;
+		running_ = n_threads_ - 1;
+		generation_++;
+		pthread_cond_broadcast(&start_);
+		pthread_mutex_unlock(&mutex_);
+
+		job(0);
+
+		pthread_mutex_lock(&mutex_);
+		while (running_)
+			pthread_cond_wait(&done_, &mutex_);
+		pthread_mutex_unlock(&mutex_);
+	}
+
+private:
+	struct worker {
+		thread_pool *pool;
+		int index;
+		pthread_t thread;
+	};
+
+	static void *worker_main_(void *arg) {
+		auto self = static_cast<worker *>(arg);
+		auto pool = self->pool;
+		unsigned long seen = 0;
+
+		while (true) {
+			pthread_mutex_lock(&pool->mutex_);
+			while (!pool->shutdown_ && pool->generation_ == seen)
+				pthread_cond_wait(&pool->start_, &pool->mutex_);
+
+			if (pool->shutdown_) {
+				pthread_mutex_unlock(&pool->mutex_);
+				return nullptr;
+			}
+
+			seen = pool->generation_;
+			auto job = pool->job_;
+			auto ctx = pool->ctx_;
+			pthread_mutex_unlock(&pool->mutex_);
+
+			job(ctx, self->index);
+
+			pthread_mutex_lock(&pool->mutex_);
+			if (!--pool->running_)
+				pthread_cond_signal(&pool->done_);
+			pthread_mutex_unlock(&pool->mutex_);
+		}
+	}
+
+	const int n_threads_;
+	worker *const workers_;
+
+	pthread_mutex_t mutex_;
+	pthread_cond_t start_;
+	pthread_cond_t done_;
+
+	void (*job_)(void *, int) = nullptr;
+	void *ctx_ = nullptr;
+	unsigned long generation_ = 0;
+	int running_ = 0;
+	bool shutdown_ = false;
+};
+
+// Lets the threads of a pool wait for each other in the middle of a job,
+// for jobs that go through many short phases. Waiting threads spin for a
+// while before giving up their CPU, since the waits are usually short, but
+// there may be more threads than CPUs.
+struct spin_barrier {
+	explicit spin_barrier(int n_threads)
+	: n_threads_{n_threads} { }
+
+	spin_barrier(const spin_barrier &other) = delete;
+	spin_barrier(spin_barrier &&other) = delete;
+	spin_barrier &operator=(const spin_barrier &other) = delete;
+	spin_barrier &operator=(spin_barrier &&other) = delete;
+
+	// Returns once all n_threads threads have called it. Everything any of
+	// them wrote before is visible to all of them after.
+	void wait() {
+		unsigned int generation = __atomic_load_n(&generation_, __ATOMIC_ACQUIRE);
+
+		if (__atomic_add_fetch(&waiting_, 1, __ATOMIC_ACQ_REL) == n_threads_) {
+			__atomic_store_n(&waiting_, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&generation_, generation + 1, __ATOMIC_RELEASE);
+			return;
+		}
+
+		for (int spins = 0; __atomic_load_n(&generation_, __ATOMIC_ACQUIRE) == generation; spins++) {
+			if (spins >= max_spins) sched_yield();
+		}
+	}
+
+private:
+	static constexpr int max_spins = 1000;
+
+	const int n_threads_;
+	int waiting_ = 0;
+	unsigned int generation_ = 0;
+};
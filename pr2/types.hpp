@@ -0,0 +1,46 @@
+#pragma once
+
+struct vertex {
+	int x, y;
+
+	bool operator==(const vertex &other) const {
+		return other.x == x && other.y == y;
+	}
+};
+
+struct neighbor {
+	vertex at;
+	int time;
+};
+
+struct lift {
+	vertex from;
+	vertex to;
+
+	int leaves_every;
+	int travel_time;
+
+	// How long someone arriving at the given time waits for a departure.
+	int wait(int time) const {
+		return wait(leaves_every, time);
+	}
+
+	// The same for any lift leaving every given number of units, for the
+	// graphs that keep only that and not the whole lift.
+	static int wait(int leaves_every, int time) {
+		int last_departure = time % leaves_every;
+		return last_departure ? leaves_every - last_departure : 0;
+	}
+
+	// Whether this lift is never slower than the other one between the same
+	// cells, whatever the arrival time. Departures happen at multiples of
+	// the period, so that's when its travel time is no longer, and either it
+	// departs whenever the other one does (its period divides the other's),
+	// or its worst wait and travel is no longer than the other's travel
+	// alone. A smaller period alone isn't enough, since the departures of
+	// the two need not line up.
+	bool dominates(const lift &other) const {
+		return travel_time <= other.travel_time && (other.leaves_every % leaves_every == 0
+			|| leaves_every - 1 + travel_time <= other.travel_time);
+	}
+};
@@ -0,0 +1,336 @@
+#include <cstdio>  // printf, fprintf
+#include <cstdlib> // atoi
+#include <cstring> // strcmp
+#include <fcntl.h> // open
+#include <unistd.h> // close
+
+#include "../common/fast_io.hpp"
+#include "../common/timing.hpp"
+#include "trie.hpp"
+
+// Reads commands in the same format as pr3 from stdin, and replays them
+// against a fresh trie for each run, with the output of P going to
+// /dev/null. Reports the median time of the whole stream, the throughput
+// of each kind of command (timed one by one, so it includes the overhead
+// of reading the clock), the memory the trie takes up at the end, and the
+// peak RSS of the process.
+//
+// With lookups, replays a generated stream instead, which inserts a set of
+// random values and then looks them up, along with values that aren't
+// there, and tries to delete the latter. Also reports the memory the trie
+// takes up with just the inserts, which lookups and failed deletes
+// shouldn't add to.
+//
+// With wide, replays random inserts and lookups into a trie with a root
+// as wide as given (a million by default), so that the root and the nodes
+// under it have far more slots than children.
+//
+// With batch, compares inserting and looking up values one by one against
+// insert_batch and find_batch, on random values and on clusters of
+// consecutive ones, checking that they give the same answers.
+//
+// Usage: pr3-bench [runs] < tests/3.in
+//        pr3-bench lookups [runs]
+//        pr3-bench wide [n] [runs]
+//        pr3-bench batch [runs]
+
+namespace {
+
+struct command {
+	// Into kinds.
+	int kind;
+	int value;
+};
+
+const char kinds[] = {'I', 'L', 'D', 'P'};
+constexpr int n_kinds = 4;
+
+int kind_index(char kind) {
+	for (int i = 0; i < n_kinds; i++) {
+		if (kinds[i] == kind) return i;
+	}
+
+	return -1;
+}
+
+struct lcg {
+	unsigned long long state;
+
+	int next(int bound) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<int>((state >> 33) % bound);
+	}
+};
+
+// Fills commands with the lookup-heavy stream, returns how many there are.
+int generate_lookups(command *&commands, int &n, int &k) {
+	constexpr int n_inserts = 100000;
+	constexpr int n_lookups = 2000000;
+	constexpr int max_value = 268435455;
+	n = 32;
+	k = 8;
+
+	int n_cmds = n_inserts + n_lookups;
+	commands = new command[n_cmds];
+	lcg rng{42};
+
+	for (int i = 0; i < n_inserts; i++)
+		commands[i] = {kind_index('I'), rng.next(max_value + 1)};
+
+	// One in 8 is a delete, and every other lookup is of an inserted value.
+	// Deletes are of random values, which are almost never there.
+	for (int i = n_inserts; i < n_cmds; i++) {
+		int roll = rng.next(16);
+		char kind = roll < 14 ? 'L' : 'D';
+		int v = roll & 1 && kind == 'L'
+			? commands[rng.next(n_inserts)].value : rng.next(max_value + 1);
+		commands[i] = {kind_index(kind), v};
+	}
+
+	return n_cmds;
+}
+
+// Fills commands with random inserts and lookups of values below 2^28,
+// half of each, returns how many there are.
+int generate_wide(command *&commands, int n, int &k) {
+	constexpr int n_cmds = 200000;
+	constexpr int max_value = 268435455;
+	k = 8;
+
+	commands = new command[n_cmds];
+	lcg rng{static_cast<unsigned long long>(n)};
+
+	for (int i = 0; i < n_cmds; i++)
+		commands[i] = {kind_index(rng.next(2) ? 'I' : 'L'), rng.next(max_value + 1)};
+
+	return n_cmds;
+}
+
+// Random values, or runs of 64 consecutive ones from random starts, with
+// every 8th repeating an earlier one so that some inserts fail.
+void generate_values(int *values, int count, bool clustered, lcg &rng) {
+	constexpr int max_value = 268435455;
+	constexpr int cluster = 64;
+
+	for (int i = 0; i < count; i++) {
+		if (i && !rng.next(8)) values[i] = values[rng.next(i)];
+		else if (!clustered) values[i] = rng.next(max_value + 1);
+		else if (i % cluster) values[i] = values[i - 1] + 1 <= max_value ? values[i - 1] + 1 : 0;
+		else values[i] = rng.next(max_value + 1);
+	}
+}
+
+int bench_batch(int runs) {
+	constexpr int n = 32, k = 8;
+	constexpr int count = 1000000;
+
+	int *inserted_values = new int[count];
+	int *found_values = new int[count];
+	// What insert and find returned one by one.
+	bool *expected_inserted = new bool[count];
+	bool *expected_found = new bool[count];
+	bool *results = new bool[count];
+	long long *samples = new long long[runs];
+	int mismatches = 0;
+
+	printf("%d values, n = %d, k = %d, %d runs\n", count, n, k, runs);
+
+	for (int clustered = 0; clustered < 2; clustered++) {
+		lcg rng{42};
+		generate_values(inserted_values, count, clustered, rng);
+		// Half of them inserted, the others likely not.
+		generate_values(found_values, count, clustered, rng);
+		for (int i = 0; i < count; i += 2)
+			found_values[i] = inserted_values[rng.next(count)];
+
+		const char *set = clustered ? "clustered" : "random";
+		double ns[2][2];
+
+		for (int batched = 0; batched < 2; batched++) {
+			for (int r = 0; r < runs; r++) {
+				trie t{n, k};
+
+				auto t0 = now_ns();
+				if (batched) {
+					t.insert_batch(inserted_values, count, results);
+				} else {
+					for (int i = 0; i < count; i++)
+						results[i] = t.insert(inserted_values[i]);
+				}
+				samples[r] = now_ns() - t0;
+
+				for (int i = 0; i < count; i++) {
+					if (batched) mismatches += results[i] != expected_inserted[i];
+					else expected_inserted[i] = results[i];
+				}
+			}
+			ns[0][batched] = median_ns(samples, runs);
+
+			trie t{n, k};
+			for (int i = 0; i < count; i++) t.insert(inserted_values[i]);
+
+			for (int r = 0; r < runs; r++) {
+				auto t0 = now_ns();
+				if (batched) {
+					t.find_batch(found_values, count, results);
+				} else {
+					for (int i = 0; i < count; i++)
+						results[i] = t.find(found_values[i]);
+				}
+				samples[r] = now_ns() - t0;
+
+				for (int i = 0; i < count; i++) {
+					if (batched) mismatches += results[i] != expected_found[i];
+					else expected_found[i] = results[i];
+				}
+			}
+			ns[1][batched] = median_ns(samples, runs);
+		}
+
+		const char *ops[] = {"insert", "find"};
+		for (int op = 0; op < 2; op++) {
+			printf("%-9s %-6s  one by one %12.0f /s  batched %12.0f /s  %5.2fx\n",
+					set, ops[op], count * 1e9 / ns[op][0], count * 1e9 / ns[op][1],
+					ns[op][0] / ns[op][1]);
+		}
+	}
+
+	if (mismatches) printf("%d batched answers differ!\n", mismatches);
+
+	delete[] samples;
+	delete[] results;
+	delete[] expected_found;
+	delete[] expected_inserted;
+	delete[] found_values;
+	delete[] inserted_values;
+	return mismatches ? 1 : 0;
+}
+
+} // namespace anonymous
+
+int main(int argc, char **argv) {
+	if (argc > 1 && !strcmp(argv[1], "batch")) {
+		int runs = argc > 2 ? atoi(argv[2]) : 5;
+		return bench_batch(runs < 1 ? 1 : runs);
+	}
+
+	bool lookups = argc > 1 && !strcmp(argv[1], "lookups");
+	bool wide = argc > 1 && !strcmp(argv[1], "wide");
+	int n = 1000000, k;
+	if (wide && argc > 2) n = atoi(argv[2]);
+
+	int runs_arg = 1 + lookups + 2 * wide;
+	int runs = argc > runs_arg ? atoi(argv[runs_arg]) : 5;
+	if (runs < 1) runs = 1;
+
+	command *commands;
+	int n_read = 0;
+
+	if (lookups) {
+		n_read = generate_lookups(commands, n, k);
+	} else if (wide) {
+		if (n < 1) {
+			fprintf(stderr, "usage: %s wide [n] [runs]\n", argv[0]);
+			return 1;
+		}
+
+		n_read = generate_wide(commands, n, k);
+	} else {
+		input_reader in;
+		int n_cmds, min, max;
+		if (!in.read_int(n_cmds) || !in.read_int(min) || !in.read_int(max)
+				|| !in.read_int(n) || !in.read_int(k) || n_cmds < 0) {
+			fprintf(stderr, "usage: %s [runs] < commands\n"
+					"       %s lookups [runs]\n"
+					"       %s wide [n] [runs]\n", argv[0], argv[0], argv[0]);
+			return 1;
+		}
+
+		commands = new command[n_cmds > 0 ? n_cmds : 1];
+
+		while (n_read < n_cmds) {
+			char kind;
+			int v = -1;
+			if (!in.read_char(kind)) break;
+			if ((kind == 'I' || kind == 'L' || kind == 'D') && !in.read_int(v))
+				break;
+			int i = kind_index(kind);
+			if (i < 0) continue;
+
+			commands[n_read++] = {i, v};
+		}
+	}
+
+	int null_fd = open("/dev/null", O_WRONLY);
+	output_writer out{null_fd};
+	// Where lookups go, so that they aren't optimized away.
+	volatile bool found;
+
+	auto replay = [&] (trie &t, int i) {
+		auto [kind, v] = commands[i];
+
+		switch (kinds[kind]) {
+			case 'I': t.insert(v); break;
+			case 'L': found = t.find(v); break;
+			case 'D': t.remove(v); break;
+			case 'P': t.print_inorder(out); break;
+		}
+	};
+
+	long long *samples = new long long[runs];
+	long long memory = 0;
+
+	for (int r = 0; r < runs; r++) {
+		trie t{n, k};
+
+		auto t0 = now_ns();
+		for (int i = 0; i < n_read; i++) replay(t, i);
+		samples[r] = now_ns() - t0;
+
+		memory = t.memory_bytes();
+	}
+
+	auto median = median_ns(samples, runs);
+	printf("%d commands, n = %d, k = %d, %d runs\n", n_read, n, k, runs);
+	printf("whole stream   %10.3f ms %12.0f commands/s\n", median / 1e6, n_read * 1e9 / median);
+
+	long long kind_ns[n_kinds] = {};
+	int kind_count[n_kinds] = {};
+
+	for (int r = 0; r < runs; r++) {
+		trie t{n, k};
+
+		for (int i = 0; i < n_read; i++) {
+			auto t0 = now_ns();
+			replay(t, i);
+			kind_ns[commands[i].kind] += now_ns() - t0;
+			if (!r) kind_count[commands[i].kind]++;
+		}
+	}
+
+	for (int i = 0; i < n_kinds; i++) {
+		if (!kind_count[i]) continue;
+
+		double ns = static_cast<double>(kind_ns[i]) / runs;
+		printf("%c %8d      %10.3f ms %12.0f commands/s\n",
+				kinds[i], kind_count[i], ns / 1e6, kind_count[i] * 1e9 / ns);
+	}
+
+	printf("trie memory    %10.1f KiB\n", memory / 1024.0);
+
+	if (lookups) {
+		trie t{n, k};
+		for (int i = 0; i < n_read; i++) {
+			if (kinds[commands[i].kind] == 'I') t.insert(commands[i].value);
+		}
+
+		printf("inserts only   %10.1f KiB\n", t.memory_bytes() / 1024.0);
+	}
+
+	printf("peak RSS       %10.1f KiB\n", peak_rss_bytes() / 1024.0);
+
+	out.flush();
+	close(null_fd);
+	delete[] samples;
+	delete[] commands;
+}
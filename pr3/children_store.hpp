@@ -0,0 +1,341 @@
+#pragma once
+
+#include "slab_pool.hpp"
+
+// Nodes and their children refer to each other by 32-bit index, with 0 for
+// none.
+using node_ref = unsigned int;
+
+// The children of nodes of one width, each node's referred to by a 32-bit
+// handle, with 0 for none.
+//
+// A node with few children keeps them in a sparse block, of just the
+// children it has, packed in slot order. For widths up to
+// max_bitmap_width, the block starts with a bitmap of the taken slots, and
+// a child is found by counting the bits set before its slot. Wider nodes
+// would have too many words of it to count, so their blocks list the taken
+// slots in order instead, and a child is found by binary search. Sparse
+// blocks hold 1, 2, 4, ... up to max_sparse children, each capacity in a
+// pool of its own, and a node moves up to the next one when its block is
+// full, and to a dense array of every slot once a sparse block would be as
+// big as that, or it has more than max_sparse children. After removing a
+// child, it moves back down once it's down to half of the smaller block,
+// so that inserting and removing the same child doesn't keep moving it.
+// Every block starts with the number of children in it.
+//
+// The upper class_bits of a handle say which pool its block is from, 0
+// for the dense arrays, the rest is the index in it.
+struct children_store {
+	children_store(int width, int slab_bits)
+	: width_{width}, bitmap_words_{width <= max_bitmap_width ? (width + 31) / 32 : 0} {
+		n_classes_ = 1;
+		while (n_classes_ < max_classes && capacity_(n_classes_) <= max_sparse
+				&& sparse_length_(n_classes_) < 1 + width)
+			n_classes_++;
+
+		pools_ = new slab_pool<node_ref> *[n_classes_];
+		pools_[0] = new slab_pool<node_ref>{1 + width, slab_bits};
+		for (int c = 1; c < n_classes_; c++)
+			pools_[c] = new slab_pool<node_ref>{sparse_length_(c), slab_bits};
+	}
+
+	children_store(const children_store &other) = delete;
+	children_store(children_store &&other) = delete;
+	children_store &operator=(const children_store &other) = delete;
+	children_store &operator=(children_store &&other) = delete;
+
+	~children_store() {
+		for (int c = 0; c < n_classes_; c++)
+			delete pools_[c];
+		delete[] pools_;
+	}
+
+	// The child in the given slot, or 0 if it's empty.
+	node_ref get(unsigned int handle, int slot) const {
+		int c = class_of_(handle);
+		node_ref *block = block_(handle);
+		if (!c) return block[1 + slot];
+
+		if (bitmap_words_) {
+			node_ref *bitmap = block + 1;
+			if (!(bitmap[slot / 32] & 1u << slot % 32)) return 0;
+			return children_(block, c)[rank_(bitmap, slot)];
+		}
+
+		int i = lower_bound_(block, slot);
+		return i < static_cast<int>(block[0]) && static_cast<int>(slots_(block)[i]) == slot
+			? children_(block, c)[i] : 0;
+	}
+
+	// The first slot from the given one on that isn't empty, or -1 if
+	// there's none.
+	int next_slot(unsigned int handle, int from) const {
+		int c = class_of_(handle);
+		node_ref *block = block_(handle);
+
+		if (!c) {
+			for (int slot = from; slot < width_; slot++) {
+				if (block[1 + slot]) return slot;
+			}
+
+			return -1;
+		}
+
+		if (!bitmap_words_) {
+			int i = lower_bound_(block, from);
+			return i < static_cast<int>(block[0]) ? static_cast<int>(slots_(block)[i]) : -1;
+		}
+
+		node_ref *bitmap = block + 1;
+		int word = from / 32;
+		if (word >= bitmap_words_) return -1;
+
+		node_ref bits = bitmap[word] & ~0u << from % 32;
+		while (!bits) {
+			if (++word == bitmap_words_) return -1;
+			bits = bitmap[word];
+		}
+
+		return word * 32 + __builtin_ctz(bits);
+	}
+
+	void prefetch(unsigned int handle) const {
+		__builtin_prefetch(block_(handle));
+	}
+
+	// Steps through the children in slot order, starting from position 0:
+	// returns the next child and moves the position past it, or returns 0
+	// once there are none left.
+	node_ref next_child(unsigned int handle, int &position) const {
+		int c = class_of_(handle);
+		node_ref *block = block_(handle);
+
+		if (!c) {
+			while (position < width_) {
+				if (node_ref child = block[1 + position++]) return child;
+			}
+
+			return 0;
+		}
+
+		if (position == static_cast<int>(block[0])) return 0;
+		return children_(block, c)[position++];
+	}
+
+	// Calls f(slot, child) for every child, in slot order.
+	template <typename F>
+	void for_each(unsigned int handle, F f) const {
+		int c = class_of_(handle);
+		node_ref *block = block_(handle);
+
+		if (!c) {
+			for (int slot = 0; slot < width_; slot++) {
+				if (block[1 + slot]) f(slot, block[1 + slot]);
+			}
+
+			return;
+		}
+
+		node_ref *children = children_(block, c);
+
+		if (!bitmap_words_) {
+			for (int i = 0; i < static_cast<int>(block[0]); i++)
+				f(static_cast<int>(slots_(block)[i]), children[i]);
+			return;
+		}
+
+		node_ref *bitmap = block + 1;
+		for (int word = 0; word < bitmap_words_; word++) {
+			for (node_ref bits = bitmap[word]; bits; bits &= bits - 1)
+				f(word * 32 + __builtin_ctz(bits), *children++);
+		}
+	}
+
+	// Puts the child into the given empty slot, allocating the children if
+	// the handle is 0.
+	void insert(unsigned int &handle, int slot, node_ref child) {
+		if (!handle) handle = allocate_(n_classes_ > 1 ? 1 : 0);
+
+		int c = class_of_(handle);
+		if (c && static_cast<int>(block_(handle)[0]) == capacity_(c))
+			handle = move_(handle, c + 1 < n_classes_ ? c + 1 : 0);
+
+		c = class_of_(handle);
+		node_ref *block = block_(handle);
+		int count = block[0];
+
+		if (!c) {
+			block[0]++;
+			block[1 + slot] = child;
+			return;
+		}
+
+		node_ref *children = children_(block, c);
+		int i;
+
+		if (bitmap_words_) {
+			node_ref *bitmap = block + 1;
+			i = rank_(bitmap, slot);
+			bitmap[slot / 32] |= 1u << slot % 32;
+		} else {
+			node_ref *slots = slots_(block);
+			i = lower_bound_(block, slot);
+			for (int j = count; j > i; j--)
+				slots[j] = slots[j - 1];
+			slots[i] = slot;
+		}
+
+		for (int j = count; j > i; j--)
+			children[j] = children[j - 1];
+		children[i] = child;
+		block[0]++;
+	}
+
+	// Empties the given slot, freeing the children and setting the handle
+	// to 0 if it was the last one.
+	void remove(unsigned int &handle, int slot) {
+		int c = class_of_(handle);
+		node_ref *block = block_(handle);
+		int count = block[0] - 1;
+
+		if (!c) {
+			block[1 + slot] = 0;
+		} else {
+			node_ref *children = children_(block, c);
+			int i;
+
+			if (bitmap_words_) {
+				node_ref *bitmap = block + 1;
+				i = rank_(bitmap, slot);
+				bitmap[slot / 32] &= ~(1u << slot % 32);
+			} else {
+				node_ref *slots = slots_(block);
+				i = lower_bound_(block, slot);
+				for (int j = i; j < count; j++)
+					slots[j] = slots[j + 1];
+			}
+
+			for (int j = i; j < count; j++)
+				children[j] = children[j + 1];
+		}
+
+		block[0] = count;
+		if (!count) {
+			pools_[c]->free(index_of_(handle));
+			handle = 0;
+			return;
+		}
+
+		int smaller = c ? c - 1 : n_classes_ - 1;
+		if (!smaller) return;
+
+		int threshold = capacity_(smaller) / 2;
+		if (count <= (threshold ? threshold : 1))
+			handle = move_(handle, smaller);
+	}
+
+	// Memory taken up by the pools.
+	long long memory_bytes() const {
+		long long bytes = static_cast<long long>(n_classes_) * sizeof(slab_pool<node_ref> *);
+		for (int c = 0; c < n_classes_; c++)
+			bytes += pools_[c]->memory_bytes();
+		return bytes;
+	}
+
+private:
+	// Leaves 2^27 blocks of each capacity, far more than would fit into
+	// memory for any width.
+	static constexpr int class_bits = 5;
+	static constexpr int max_classes = 1 << class_bits;
+	static constexpr unsigned int index_mask = (1u << (32 - class_bits)) - 1;
+
+	// Bounds the words counted to find a child, and the children moved to
+	// insert or remove one.
+	static constexpr int max_bitmap_width = 256;
+	static constexpr int max_sparse = 64;
+
+	static int capacity_(int c) {
+		return 1 << (c - 1);
+	}
+
+	static int class_of_(unsigned int handle) {
+		return static_cast<int>(handle >> (32 - class_bits));
+	}
+
+	static unsigned int index_of_(unsigned int handle) {
+		return handle & index_mask;
+	}
+
+	int sparse_length_(int c) const {
+		return 1 + (bitmap_words_ ? bitmap_words_ : capacity_(c)) + capacity_(c);
+	}
+
+	node_ref *block_(unsigned int handle) const {
+		return (*pools_[class_of_(handle)])[index_of_(handle)];
+	}
+
+	// The children of a sparse block, after its bitmap or its slots.
+	node_ref *children_(node_ref *block, int c) const {
+		return block + 1 + (bitmap_words_ ? bitmap_words_ : capacity_(c));
+	}
+
+	static node_ref *slots_(node_ref *block) {
+		return block + 1;
+	}
+
+	unsigned int allocate_(int c) {
+		return static_cast<unsigned int>(c) << (32 - class_bits) | pools_[c]->allocate();
+	}
+
+	// Number of children before the given slot in a bitmap.
+	int rank_(const node_ref *bitmap, int slot) const {
+		int rank = 0;
+		for (int word = 0; word < slot / 32; word++)
+			rank += __builtin_popcount(bitmap[word]);
+		return rank + __builtin_popcount(bitmap[slot / 32] & ((1u << slot % 32) - 1));
+	}
+
+	// Index of the first of the listed slots not before the given one.
+	static int lower_bound_(node_ref *block, int slot) {
+		node_ref *slots = slots_(block);
+		int lo = 0, hi = block[0];
+
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+			if (static_cast<int>(slots[mid]) < slot) lo = mid + 1;
+			else hi = mid;
+		}
+
+		return lo;
+	}
+
+	// Moves the children into a new block of the given class, returns its
+	// handle. They have to fit.
+	unsigned int move_(unsigned int handle, int to) {
+		unsigned int moved = allocate_(to);
+		node_ref *block = block_(moved);
+		block[0] = block_(handle)[0];
+
+		node_ref *children = to ? children_(block, to) : nullptr;
+		int i = 0;
+
+		for_each(handle, [&] (int slot, node_ref child) {
+			if (!to) {
+				block[1 + slot] = child;
+				return;
+			}
+
+			if (bitmap_words_) block[1 + slot / 32] |= 1u << slot % 32;
+			else slots_(block)[i] = slot;
+			children[i++] = child;
+		});
+
+		pools_[class_of_(handle)]->free(index_of_(handle));
+		return moved;
+	}
+
+	const int width_;
+	const int bitmap_words_;
+	int n_classes_;
+	slab_pool<node_ref> **pools_;
+};
@@ -1,176 +1,79 @@
-#include <cstdio>
-
-struct trie_node {
-	explicit trie_node(int value)
-	: value{value}, children{nullptr} { }
-
-	trie_node(const trie_node &other) = delete;
-	trie_node(trie_node &&other) = delete;
-	trie_node &operator=(const trie_node &other) = delete;
-	trie_node &operator=(trie_node &&other) = delete;
-
-	~trie_node() {
-		delete[] children;
-	}
-
-	void delete_children(int width, int next_width) {
-		if (!children) return;
-		for (int i = 0; i < width; i++) {
-			if (children[i]) {
-				children[i]->delete_children(next_width, next_width);
-				delete children[i];
-			}
-		}
-	}
-
-	void force_children(int width) {
-		if (!children)
-			children = new trie_node *[width]{};
-	}
-
-	void print_inorder(int width, int next_width) {
-		printf("%d ", value);
-		if (!children) return;
-
-		for (int i = 0; i < width; i++) {
-			if (children[i]) children[i]->print_inorder(next_width, next_width);
-		}
-	}
-
-	bool has_children(int width) const {
-		if (!children) return false;
-
-		for (int i = 0; i < width; i++) {
-			if (children[i]) return true;
-		}
-
-		return false;
-	}
-
-	int value;
-	trie_node **children;
-};
-
-struct trie {
-	trie(int n, int k)
-	: n{n}, k{k}, root{nullptr} { }
-
-	trie(const trie &other) = delete;
-	trie(trie &&other) = delete;
-	trie &operator=(const trie &other) = delete;
-	trie &operator=(trie &&other) = delete;
-
-	~trie() {
-		if (root) {
-			root->delete_children(n, k);
-			delete root;
-		}
-	}
-
-	bool insert(int value) {
-		auto at = find_slot_(value);
-		if (*at) return false;
-
-		*at = new trie_node{value};
-		return true;
-	}
-
-	bool find(int value) {
-		return (*find_slot_(value)) != nullptr;
-	}
-
-	bool remove(int value) {
-		trie_node **at = find_slot_(value);
-		if (!*at) return false;
-		int at_width = at == &root ? n : k;
-
-		if (!(*at)->has_children(at_width)) {
-			delete *at;
-			*at = nullptr;
-			return true;
-		}
-
-		trie_node **leftmost = at;
-		int leftmost_width = at_width;
-		while ((*leftmost)->has_children(leftmost_width)) {
-			for (int i = 0; i < leftmost_width; i++) {
-				if ((*leftmost)->children[i]) {
-					leftmost = &(*leftmost)->children[i];
-					break;
-				}
-			}
-			leftmost_width = k;
-		}
-
-		(*at)->value = (*leftmost)->value;
-		delete *leftmost;
-		*leftmost = nullptr;
-
-		return true;
-	}
-
-	void print_inorder() {
-		if (root) root->print_inorder(n, k);
-		printf("\n");
-	}
-
-private:
-	// Returns the pointer to the slot which is supposed to hold
-	// the pointer to node of the given value.
-	trie_node **find_slot_(int value) {
-		trie_node **cur = &root;
-
-		int key = value;
-		while (*cur && (*cur)->value != value) {
-			int width = cur == &root ? n : k;
-			// Force the children array to be allocated
-			// since we'll be taking a pointer into it.
-			(*cur)->force_children(width);
-			cur = &((*cur)->children[key % width]);
-			key /= width;
-		}
-
-		return cur;
-	}
-
-	int n, k;
-	trie_node *root;
-};
+#include "../common/fast_io.hpp"
+#include "trie.hpp"
 
 int main() {
+	input_reader in;
+	output_writer out;
+
 	int n_cmds;
-	scanf("%d", &n_cmds);
+	in.read_int(n_cmds);
 
 	int min, max;
-	scanf("%d%d", &min, &max);
+	in.read_int(min);
+	in.read_int(max);
 
 	int n, k;
-	scanf("%d%d", &n, &k);
+	in.read_int(n);
+	in.read_int(k);
 
 	trie t{n, k};
 
+	// Runs of I or L commands are done in batches, which give the same
+	// answers in the same order.
+	constexpr int batch_size = 256;
+	int batch[batch_size];
+	bool results[batch_size];
+	int n_batched = 0;
+	char batched = 0;
+
+	auto flush_batch = [&] {
+		if (batched == 'I') {
+			t.insert_batch(batch, n_batched, results);
+			for (int i = 0; i < n_batched; i++) {
+				if (results[i]) continue;
+				out.write_int(batch[i]);
+				out.write_str(" exist\n");
+			}
+		} else if (batched == 'L') {
+			t.find_batch(batch, n_batched, results);
+			for (int i = 0; i < n_batched; i++) {
+				out.write_int(batch[i]);
+				out.write_str(results[i]
+					? " exist\n"
+					: " not exist\n");
+			}
+		}
+
+		n_batched = 0;
+	};
+
 	while (n_cmds--) {
-		char cmd[2];
+		char cmd;
 		int v = -1;
-		scanf("%1s", cmd);
-		if (cmd[0] == 'I' || cmd[0] == 'L' || cmd[0] == 'D')
-			scanf("%d", &v);
+		if (!in.read_char(cmd)) break;
+		// Stops at a command without a value, like scanf would.
+		if ((cmd == 'I' || cmd == 'L' || cmd == 'D') && !in.read_int(v))
+			break;
+
+		if (cmd == 'I' || cmd == 'L') {
+			if (cmd != batched || n_batched == batch_size) flush_batch();
+			batched = cmd;
+			batch[n_batched++] = v;
+			continue;
+		}
 
-		switch (cmd[0]) {
-			case 'I':
-				if (!t.insert(v))
-					printf("%d exist\n", v);
-				break;
+		flush_batch();
+
+		switch (cmd) {
 			case 'D':
-				if (!t.remove(v))
-					printf("%d not exist\n", v);
-				break;
-			case 'L': printf("%d %s\n", v,
-					t.find(v)
-					? "exist"
-					: "not exist");
+				if (!t.remove(v)) {
+					out.write_int(v);
+					out.write_str(" not exist\n");
+				}
 				break;
-			case 'P': t.print_inorder(); break;
+			case 'P': t.print_inorder(out); break;
 		}
 	}
+
+	flush_batch();
 }
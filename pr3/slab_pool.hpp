@@ -0,0 +1,93 @@
+#pragma once
+
+// Fixed-size slots of slot_length Ts each, carved out of slabs of
+// 2^slab_bits slots, and addressed by 32-bit indices rather than pointers.
+// Slabs are never moved or freed before the pool is, so pointers to slots
+// stay valid until their slot is freed. Index 0 is never handed out, so it
+// can stand for null. Freed slots are kept on a free list, threaded through
+// their first bytes, so a slot must be at least 4 bytes long, and handed
+// out again before any new ones.
+//
+// Compared to allocating every slot with new, there are no malloc headers
+// or alignment padding between slots, and the indices take up half the
+// space of pointers.
+template <typename T>
+struct slab_pool {
+	slab_pool(int slot_length, int slab_bits)
+	: slot_length_{slot_length}, slab_bits_{slab_bits} { }
+
+	slab_pool(const slab_pool &other) = delete;
+	slab_pool(slab_pool &&other) = delete;
+	slab_pool &operator=(const slab_pool &other) = delete;
+	slab_pool &operator=(slab_pool &&other) = delete;
+
+	~slab_pool() {
+		for (int i = 0; i < n_slabs_; i++)
+			delete[] slabs_[i];
+		delete[] slabs_;
+	}
+
+	// Returns a slot with every T value initialized.
+	unsigned int allocate() {
+		unsigned int index;
+
+		if (free_) {
+			index = free_;
+			__builtin_memcpy(&free_, (*this)[index], sizeof free_);
+		} else {
+			while (next_ >> slab_bits_ >= static_cast<unsigned int>(n_slabs_))
+				add_slab_();
+			index = next_++;
+		}
+
+		T *slot = (*this)[index];
+		for (int i = 0; i < slot_length_; i++)
+			slot[i] = T{};
+
+		return index;
+	}
+
+	void free(unsigned int index) {
+		__builtin_memcpy((*this)[index], &free_, sizeof free_);
+		free_ = index;
+	}
+
+	T *operator[](unsigned int index) const {
+		unsigned int mask = (1u << slab_bits_) - 1;
+		return slabs_[index >> slab_bits_] + static_cast<long long>(index & mask) * slot_length_;
+	}
+
+	// Memory taken up by the slabs and the table of them.
+	long long memory_bytes() const {
+		return (static_cast<long long>(n_slabs_) * sizeof(T) * slot_length_ << slab_bits_)
+			+ static_cast<long long>(slabs_capacity_) * sizeof(T *);
+	}
+
+private:
+	void add_slab_() {
+		if (n_slabs_ == slabs_capacity_) {
+			int capacity = slabs_capacity_ ? 2 * slabs_capacity_ : 16;
+			T **slabs = new T *[capacity];
+
+			for (int i = 0; i < n_slabs_; i++)
+				slabs[i] = slabs_[i];
+
+			delete[] slabs_;
+			slabs_ = slabs;
+			slabs_capacity_ = capacity;
+		}
+
+		slabs_[n_slabs_++] = new T[static_cast<long long>(slot_length_) << slab_bits_];
+	}
+
+	const int slot_length_;
+	const int slab_bits_;
+
+	T **slabs_ = nullptr;
+	int n_slabs_ = 0;
+	int slabs_capacity_ = 0;
+
+	// Slot 0 is skipped.
+	unsigned int next_ = 1;
+	unsigned int free_ = 0;
+};
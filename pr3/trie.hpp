@@ -0,0 +1,327 @@
+#pragma once
+
+#include "../common/fast_io.hpp"
+#include "children_store.hpp"
+#include "slab_pool.hpp"
+
+// Nodes live in a slab_pool, and their children in a children_store for
+// each width.
+struct trie_node {
+	int value;
+	// Handle of the children in the store for the node's width, 0 if it
+	// has none.
+	unsigned int children;
+};
+
+// The root has n children, every other node has k. A value descends by
+// its remainder modulo the width, and the quotient moves on to the next
+// level, until it finds the node holding it, or an empty slot.
+struct trie {
+	trie(int n, int k)
+	: n{n}, k{k}, nodes_{1, node_slab_bits}
+	, root_children_{n, 0}, children_{k, children_slab_bits} { }
+
+	trie(const trie &other) = delete;
+	trie(trie &&other) = delete;
+	trie &operator=(const trie &other) = delete;
+	trie &operator=(trie &&other) = delete;
+
+	bool insert(int value) {
+		if (!root_) {
+			root_ = new_node_(value);
+			return true;
+		}
+
+		return insert_below_(root_, value, value);
+	}
+
+	bool find(int value) {
+		node_ref parent;
+		int slot;
+		return lookup_(value, parent, slot) != 0;
+	}
+
+	// Inserts count values, setting inserted[i] to what insert(values[i])
+	// would return if they were inserted one by one, in order.
+	void insert_batch(const int *values, int count, bool *inserted) {
+		descent descents[batch_group];
+
+		for (int first = 0; first < count; first += batch_group) {
+			int n = count - first < batch_group ? count - first : batch_group;
+			descend_batch_(values + first, n, descents);
+
+			// Nodes are never moved or freed by inserting, so the descents
+			// can carry on from where they stopped, even past values
+			// inserted by the ones before them. Found values were already
+			// there before the batch.
+			for (int i = 0; i < n; i++) {
+				auto [node, key, found] = descents[i];
+				int value = values[first + i];
+
+				if (found) inserted[first + i] = false;
+				else if (!node) inserted[first + i] = insert(value);
+				else inserted[first + i] = insert_below_(node, key, value);
+			}
+		}
+	}
+
+	// Looks up count values, setting found[i] to what find(values[i]) would
+	// return.
+	void find_batch(const int *values, int count, bool *found) {
+		descent descents[batch_group];
+
+		for (int first = 0; first < count; first += batch_group) {
+			int n = count - first < batch_group ? count - first : batch_group;
+			descend_batch_(values + first, n, descents);
+
+			for (int i = 0; i < n; i++)
+				found[first + i] = descents[i].found;
+		}
+	}
+
+	bool remove(int value) {
+		node_ref parent;
+		int slot;
+		node_ref at = lookup_(value, parent, slot);
+		if (!at) return false;
+
+		// A node with children takes over the value of the leftmost leaf
+		// below it, which is removed instead.
+		if (nodes_[at]->children) {
+			node_ref leftmost = at;
+			while (unsigned int children = nodes_[leftmost]->children) {
+				parent = leftmost;
+				slot = store_(parent).next_slot(children, 0);
+				leftmost = store_(parent).get(children, slot);
+			}
+
+			nodes_[at]->value = nodes_[leftmost]->value;
+			at = leftmost;
+		}
+
+		nodes_.free(at);
+		if (parent) store_(parent).remove(nodes_[parent]->children, slot);
+		else root_ = 0;
+
+		return true;
+	}
+
+	// Walks the values in the order print_inorder prints them, each node
+	// before its children, keeping the path to the current node on a stack
+	// of its own rather than recursing. The trie mustn't change while it's
+	// walked.
+	struct cursor {
+		explicit cursor(trie &t)
+		: t_{t}, next_{t.root_} { }
+
+		cursor(const cursor &other) = delete;
+		cursor(cursor &&other) = delete;
+		cursor &operator=(const cursor &other) = delete;
+		cursor &operator=(cursor &&other) = delete;
+
+		~cursor() {
+			delete[] path_;
+		}
+
+		// Returns false once every value has been walked.
+		bool next(int &value) {
+			node_ref node = next_;
+			next_ = 0;
+
+			while (!node && depth_) {
+				auto &top = path_[depth_ - 1];
+				node = top.store->next_child(top.children, top.position);
+				if (!node) depth_--;
+			}
+
+			if (!node) return false;
+
+			auto at = t_.nodes_[node];
+			if (at->children) push_({&t_.store_(node), at->children, 0});
+			value = at->value;
+			return true;
+		}
+
+	private:
+		struct frame {
+			const children_store *store;
+			unsigned int children;
+			// Into the children, see children_store::next_child.
+			int position;
+		};
+
+		// The depth is bounded by the number of digits of the values in
+		// base k, unless k is 1.
+		void push_(frame f) {
+			if (depth_ == capacity_) {
+				int capacity = capacity_ ? 2 * capacity_ : 64;
+				frame *path = new frame[capacity];
+
+				for (int i = 0; i < depth_; i++)
+					path[i] = path_[i];
+
+				delete[] path_;
+				path_ = path;
+				capacity_ = capacity;
+			}
+
+			path_[depth_++] = f;
+		}
+
+		trie &t_;
+		// The root, until the first call to next.
+		node_ref next_;
+		frame *path_ = nullptr;
+		int depth_ = 0;
+		int capacity_ = 0;
+	};
+
+	void print_inorder(output_writer &out) {
+		cursor c{*this};
+		int value;
+
+		while (c.next(value)) {
+			out.write_int(value);
+			out.write_char(' ');
+		}
+
+		out.write_char('\n');
+	}
+
+	// Memory taken up by the nodes and their children.
+	long long memory_bytes() const {
+		return nodes_.memory_bytes() + root_children_.memory_bytes() + children_.memory_bytes();
+	}
+
+private:
+	static constexpr int node_slab_bits = 12;
+	static constexpr int children_slab_bits = 10;
+	// Values descending together in the batch functions, enough to keep
+	// several cache misses in flight.
+	static constexpr int batch_group = 16;
+
+	// Where the descent of a value stopped: at the node holding it, or at
+	// the last node on its path, with what's left of the key to descend by
+	// from there. The node is 0 if the trie is empty.
+	struct descent {
+		node_ref node;
+		int key;
+		bool found;
+	};
+
+	int width_(node_ref node) const {
+		return node == root_ ? n : k;
+	}
+
+	// There's only ever one root, so only one block of its children at a
+	// time, which needs no slabs of them.
+	children_store &store_(node_ref node) {
+		return node == root_ ? root_children_ : children_;
+	}
+
+	node_ref new_node_(int value) {
+		node_ref added = nodes_.allocate();
+		*nodes_[added] = {value, 0};
+		return added;
+	}
+
+	// Inserts the value below the given node on its path, with what's left
+	// of its key, see insert().
+	bool insert_below_(node_ref cur, int key, int value) {
+		while (nodes_[cur]->value != value) {
+			auto at = nodes_[cur];
+			int width = width_(cur);
+			int slot = key % width;
+			key /= width;
+
+			node_ref next = at->children ? store_(cur).get(at->children, slot) : 0;
+			if (!next) {
+				store_(cur).insert(at->children, slot, new_node_(value));
+				return true;
+			}
+
+			cur = next;
+		}
+
+		return false;
+	}
+
+	// Descends for up to batch_group values at once, a level per round,
+	// without changing anything. Each round reads the nodes and prefetches
+	// their children, then reads the children and prefetches the next
+	// nodes, so the cache misses of all the values are waited for at once.
+	void descend_batch_(const int *values, int count, descent *descents) {
+		int active[batch_group];
+		int n_active = 0;
+
+		for (int i = 0; i < count; i++) {
+			descents[i] = {root_, values[i], false};
+			if (root_) active[n_active++] = i;
+		}
+
+		while (n_active) {
+			int kept = 0;
+
+			for (int j = 0; j < n_active; j++) {
+				int i = active[j];
+				node_ref node = descents[i].node;
+				auto at = nodes_[node];
+
+				if (at->value == values[i]) {
+					descents[i].found = true;
+				} else if (at->children) {
+					store_(node).prefetch(at->children);
+					active[kept++] = i;
+				}
+			}
+
+			n_active = kept;
+			kept = 0;
+
+			for (int j = 0; j < n_active; j++) {
+				auto &d = descents[active[j]];
+				int width = width_(d.node);
+
+				node_ref child = store_(d.node).get(nodes_[d.node]->children, d.key % width);
+				if (!child) continue;
+
+				d.node = child;
+				d.key /= width;
+				__builtin_prefetch(nodes_[child]);
+				active[kept++] = active[j];
+			}
+
+			n_active = kept;
+		}
+	}
+
+	// Returns the node of the given value, or 0 if there's none, without
+	// allocating anything. parent and slot are set to where it is among
+	// the children of its parent, with parent 0 for the root.
+	node_ref lookup_(int value, node_ref &parent, int &slot) {
+		node_ref cur = root_;
+		parent = 0;
+		slot = 0;
+
+		int key = value;
+		while (cur && nodes_[cur]->value != value) {
+			unsigned int children = nodes_[cur]->children;
+			if (!children) return 0;
+
+			int width = width_(cur);
+			parent = cur;
+			slot = key % width;
+			cur = store_(parent).get(children, slot);
+			key /= width;
+		}
+
+		return cur;
+	}
+
+	int n, k;
+	node_ref root_ = 0;
+
+	slab_pool<trie_node> nodes_;
+	children_store root_children_;
+	children_store children_;
+};